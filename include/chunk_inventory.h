@@ -0,0 +1,61 @@
+/*
+ * junkNAS - Chunk inventory bloom filter (shared wire format)
+ *
+ * Each node summarizes its local chunk store as a fixed-size bloom
+ * filter and serves it at GET /chunks/inventory. Peers consult learned
+ * filters to fetch from likely holders and to skip replicating chunks a
+ * peer already has. The filter indexes are carved straight out of the
+ * (already uniform) SHA-256 hex digest: JNK_INV_SLICES slices of five
+ * hex characters each select one bit, so both sides derive identical
+ * positions without extra hashing.
+ */
+
+#ifndef JUNKNAS_CHUNK_INVENTORY_H
+#define JUNKNAS_CHUNK_INVENTORY_H
+
+#include <stdint.h>
+
+#define JNK_INV_MAGIC    "JNKI"
+#define JNK_INV_VERSION  1u
+#define JNK_INV_BITS     (1u << 20)        /* 128 KiB filter */
+#define JNK_INV_BYTES    (JNK_INV_BITS / 8u)
+#define JNK_INV_SLICES   4                 /* bits set per digest */
+
+typedef struct {
+    char     magic[4];
+    uint32_t version;
+    uint64_t generation;
+    uint32_t bytes;                        /* filter size that follows */
+} jnk_inv_hdr_t;
+
+static inline uint32_t jnk_inv_bit(const char *hashhex, int slice) {
+    uint32_t v = 0;
+    for (int i = 0; i < 5; i++) {
+        char c = hashhex[slice * 5 + i];
+        uint32_t nib;
+        if (c >= '0' && c <= '9') nib = (uint32_t)(c - '0');
+        else if (c >= 'a' && c <= 'f') nib = (uint32_t)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') nib = (uint32_t)(c - 'A' + 10);
+        else nib = 0;
+        v = (v << 4) | nib;
+    }
+    return v & (JNK_INV_BITS - 1);
+}
+
+static inline void jnk_inv_set(uint8_t *bits, const char *hashhex) {
+    for (int s = 0; s < JNK_INV_SLICES; s++) {
+        uint32_t b = jnk_inv_bit(hashhex, s);
+        bits[b >> 3] |= (uint8_t)(1u << (b & 7u));
+    }
+}
+
+/* 1 = maybe present (bloom positive), 0 = definitely absent */
+static inline int jnk_inv_maybe_has(const uint8_t *bits, const char *hashhex) {
+    for (int s = 0; s < JNK_INV_SLICES; s++) {
+        uint32_t b = jnk_inv_bit(hashhex, s);
+        if (!(bits[b >> 3] & (uint8_t)(1u << (b & 7u)))) return 0;
+    }
+    return 1;
+}
+
+#endif /* JUNKNAS_CHUNK_INVENTORY_H */
@@ -0,0 +1,41 @@
+/*
+ * junkNAS - Content-defined chunking (FastCDC-style)
+ *
+ * Finds chunk boundaries from the data itself with a gear rolling hash,
+ * so an insertion near the front of a file only disturbs the chunks
+ * around the edit instead of shifting every boundary after it.
+ * Normalized chunking: a stricter mask below the average target and a
+ * looser one above it keep chunk sizes clustered around the average.
+ */
+
+#ifndef JUNKNAS_CHUNKER_H
+#define JUNKNAS_CHUNKER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    size_t min_bytes;
+    size_t avg_bytes;
+    size_t max_bytes;
+    uint64_t mask_s;               /* strict mask, used below avg_bytes */
+    uint64_t mask_l;               /* loose mask, used above avg_bytes */
+} jnk_cdc_params_t;
+
+/*
+ * Validate and derive the masks for the given size targets.
+ * Requires 0 < min <= avg <= max and a power-of-two-ish avg is not
+ * needed; masks are derived from the nearest power of two.
+ * Returns 0 on success, -1 on invalid sizes.
+ */
+int jnk_cdc_params_init(jnk_cdc_params_t *p, size_t min_bytes, size_t avg_bytes, size_t max_bytes);
+
+/*
+ * Return the length of the next chunk starting at data[0], at most len.
+ * A return shorter than len is a content-defined cut; exactly len means
+ * either the max was hit or the data ran out. Callers with more data
+ * buffered than max_bytes always get a definitive boundary.
+ */
+size_t jnk_cdc_next_boundary(const jnk_cdc_params_t *p, const uint8_t *data, size_t len);
+
+#endif /* JUNKNAS_CHUNKER_H */
@@ -0,0 +1,55 @@
+/*
+ * junkNAS - Transparent chunk compression
+ *
+ * Chunks keep their content address (SHA-256 of the uncompressed bytes);
+ * only the on-disk file is wrapped in a small header naming the codec.
+ * A cheap entropy probe skips chunks that will not compress, so media
+ * workloads pay nothing. The codec is a self-contained LZ4 block
+ * implementation, in the same spirit as the vendored sha256.
+ */
+
+#ifndef JUNKNAS_COMPRESS_H
+#define JUNKNAS_COMPRESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define JNK_COMP_MAGIC "JNKZ"
+
+enum {
+    JNK_COMP_RAW = 0,              /* payload stored verbatim */
+    JNK_COMP_LZ4 = 1,              /* payload is an LZ4 block */
+};
+
+typedef struct {
+    char     magic[4];
+    uint32_t codec;
+    uint64_t raw_len;              /* uncompressed payload length */
+} jnk_comp_hdr_t;
+
+/*
+ * Quick compressibility estimate from a byte histogram over a strided
+ * sample. Returns 1 when the data looks compressible, 0 when it is
+ * probably high-entropy (encrypted, already compressed, media).
+ */
+int jnk_compress_probe(const uint8_t *data, size_t len);
+
+/*
+ * Encode a chunk for storage. On a win, returns 1 with a malloc'd
+ * header+payload buffer in *out (caller frees). Returns 0 when the data
+ * should be stored verbatim, -1 on allocation failure. Data that happens
+ * to start with the wrapper magic is always wrapped (codec raw) so the
+ * read path can trust the prefix.
+ */
+int jnk_chunk_encode(const uint8_t *data, size_t len, uint8_t **out, size_t *out_len);
+
+/*
+ * Decode a stored chunk file. Returns 1 with the uncompressed payload in
+ * out when the file carried a valid wrapper, 0 when it is not wrapped
+ * (caller treats the file bytes as the chunk), -1 when the wrapper is
+ * present but the payload is corrupt or exceeds out_cap.
+ */
+int jnk_chunk_decode(const uint8_t *file, size_t file_len,
+                     uint8_t *out, size_t out_cap, size_t *out_len);
+
+#endif /* JUNKNAS_COMPRESS_H */
@@ -24,7 +24,15 @@
 #define DEFAULT_WG_PORT         51820
 #define DEFAULT_WG_INTERFACE    "jnk0"
 #define DEFAULT_STORAGE_SIZE    "10G"
+#define DEFAULT_CHUNK_CACHE_SIZE "256M"
+#define DEFAULT_FUSE_THREADS    0
+#define DEFAULT_COMMIT_WORKERS  4
 #define DEFAULT_WG_KEEPALIVE    25
+#define DEFAULT_CHUNKING_MODE   "fixed"
+#define DEFAULT_CDC_MIN_SIZE    "256K"
+#define DEFAULT_CDC_AVG_SIZE    "512K"
+#define DEFAULT_CDC_MAX_SIZE    "1M"
+#define DEFAULT_COMPRESSION     "off"
 
 /* Maximum lengths for various strings */
 #define MAX_PATH_LEN            4096
@@ -76,11 +84,29 @@ typedef struct {
     /* Storage configuration */
     char storage_size[32];              /* Human-readable: "10G", "500M", etc. */
     size_t max_storage_bytes;           /* Parsed value in bytes */
+    char chunk_cache_size[32];          /* Verified-chunk read cache ("0" disables) */
+    size_t chunk_cache_bytes;           /* Parsed value in bytes */
+
+    /* Chunking: "fixed" (1 MiB grid) or "cdc" (content-defined, new
+     * whole-file commits get FastCDC boundaries for dedup) */
+    char chunking_mode[8];
+    char cdc_min_size[32];
+    char cdc_avg_size[32];
+    char cdc_max_size[32];
+    size_t cdc_min_bytes;               /* Parsed values in bytes */
+    size_t cdc_avg_bytes;
+    size_t cdc_max_bytes;
+
+    /* Chunk compression: "off" or "lz4" (addresses stay hashes of the
+     * uncompressed content; incompressible chunks are stored raw) */
+    char compression[8];
 
     /* File paths */
     char data_dir[MAX_PATH_LEN];        /* Primary metadata + chunk dir */
     char data_dirs[MAX_DATA_DIRS][MAX_PATH_LEN]; /* Chunk store directories */
     size_t data_dir_count;              /* Number of chunk store dirs */
+    int data_dir_tiers[MAX_DATA_DIRS];  /* Placement hint per data_dirs entry:
+                                         * 0 = fastest (default), higher = slower */
     char mount_point[MAX_PATH_LEN];     /* Where FUSE mounts the filesystem */
     char config_file_path[MAX_PATH_LEN];/* Path to this config file */
 
@@ -114,12 +140,66 @@ typedef struct {
     /* Runtime flags */
     int verbose;                        /* Enable verbose logging? */
     int enable_fuse;                    /* Mount FUSE filesystem? */
+    int fuse_threads;                   /* FUSE loop workers (0 = library default, 1 = single-threaded) */
+    int commit_workers;                 /* Parallel chunk hash/store workers per commit (<=1 = sequential) */
     int daemon_mode;                    /* Run as background daemon? */
 
     pthread_mutex_t lock;
+
+    /* Published read-mostly snapshot (see junknas_config_snapshot_get) */
+    struct junknas_config_snapshot *snapshot;
+    pthread_mutex_t snapshot_lock;      /* Guards snapshot pointer + refcounts */
+
+    /* Debounced persistence (see junknas_config_saver_start) */
+    pthread_mutex_t save_lock;          /* Guards the dirty/stop flags below */
+    pthread_cond_t save_cond;
+    pthread_t saver_thread;
+    int save_dirty;
+    int saver_running;
+    int saver_stop;
 } junknas_config_t;
 
 
+/* ============================================================================
+ * SECTION 3b: Read-Mostly Snapshots
+ * ============================================================================
+ * Immutable, refcounted copies of the peer and mount tables. Hot read
+ * paths (remote chunk fetches, mesh sync payloads, web handlers) grab a
+ * snapshot instead of holding config->lock, so they never contend with
+ * writers or with each other. Writers mutate under config->lock as
+ * before and then call junknas_config_publish() to swap in a fresh copy;
+ * readers already holding the old snapshot keep it alive until released.
+ */
+
+typedef struct junknas_config_snapshot {
+    /* Node identity */
+    char node_state[8];
+    uint16_t web_port;
+    junknas_wg_config_t wg;
+
+    /* Bootstrap peers */
+    char bootstrap_peers[MAX_BOOTSTRAP_PEERS][MAX_ENDPOINT_LEN];
+    int bootstrap_peer_count;
+    uint64_t bootstrap_peers_updated_at;
+    int bootstrap_peer_status[MAX_BOOTSTRAP_PEERS];
+
+    /* WireGuard peers */
+    junknas_wg_peer_t wg_peers[MAX_WG_PEERS];
+    int wg_peer_count;
+    uint64_t wg_peers_updated_at;
+    int wg_peer_status[MAX_WG_PEERS];
+
+    /* Mesh data mount points */
+    char data_mount_points[MAX_DATA_MOUNT_POINTS][MAX_PATH_LEN];
+    int data_mount_point_count;
+    uint64_t data_mount_points_updated_at;
+
+    /* Lifetime (guarded by the owning config's snapshot_lock) */
+    int refs;
+    junknas_config_t *owner;
+} junknas_config_snapshot_t;
+
+
 /* ============================================================================
  * SECTION 4: Function Declarations
  * ============================================================================
@@ -223,6 +303,43 @@ int junknas_config_set_wg_peers(junknas_config_t *config, const junknas_wg_peer_
 void junknas_config_lock(junknas_config_t *config);
 void junknas_config_unlock(junknas_config_t *config);
 
+/*
+ * Acquire a reference to the current read-mostly snapshot. Never blocks
+ * on config->lock unless no snapshot has been published yet. Release
+ * with junknas_config_snapshot_put(); the snapshot is immutable.
+ * Returns NULL only on allocation failure.
+ */
+junknas_config_snapshot_t *junknas_config_snapshot_get(junknas_config_t *config);
+
+/*
+ * Drop a snapshot reference obtained from junknas_config_snapshot_get.
+ */
+void junknas_config_snapshot_put(junknas_config_snapshot_t *snap);
+
+/*
+ * Copy the current peer/mount tables into a fresh snapshot and publish
+ * it. Call after mutating those tables under config->lock (and after
+ * releasing it); readers pick up the new copy on their next get.
+ */
+void junknas_config_publish(junknas_config_t *config);
+
+/*
+ * Request that the config be persisted to config_file_path. With the
+ * saver thread running, marks a dirty flag that a background write
+ * picks up after a short debounce, so bursts of peer updates coalesce
+ * into one file rewrite. Without the saver (CLI paths), saves
+ * synchronously. Must not be called while holding config->lock.
+ */
+void junknas_config_mark_dirty(junknas_config_t *config);
+
+/*
+ * Start/stop the background persistence thread. Stop flushes any
+ * pending changes before returning.
+ * Returns 0 on success, -1 on error.
+ */
+int junknas_config_saver_start(junknas_config_t *config);
+void junknas_config_saver_stop(junknas_config_t *config);
+
 /*
  * Parse human-readable size string to bytes
  * e.g., "10G" -> 10737418240, "500M" -> 524288000
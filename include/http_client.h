@@ -0,0 +1,38 @@
+/*
+ * junkNAS - Shared HTTP client with per-peer keep-alive connections
+ */
+
+#ifndef JUNKNAS_HTTP_CLIENT_H
+#define JUNKNAS_HTTP_CLIENT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "config.h"
+
+/*
+ * Issue an HTTP request and stream the response body to out (may be NULL).
+ * The caller builds the raw request head; connections to the same host:port
+ * are kept alive and reused when the response framing allows it, with
+ * automatic reconnect when a pooled connection has gone stale.
+ * Returns 0 on a 2xx response, -1 otherwise. Status is stored in out_status.
+ */
+int junknas_http_request(const junknas_config_t *config, const char *host, uint16_t port,
+                         const char *request, const void *body, size_t body_len,
+                         FILE *out, int *out_status);
+
+/*
+ * Same as junknas_http_request but returns the response body as a
+ * NUL-terminated malloc'd buffer (empty string for empty bodies).
+ * Returns NULL on transport failure; the caller frees the result.
+ */
+char *junknas_http_request_body(const junknas_config_t *config, const char *host, uint16_t port,
+                                const char *request, const void *body, size_t body_len,
+                                int *out_status);
+
+/*
+ * Close all pooled idle connections. Called once at shutdown.
+ */
+void junknas_http_client_shutdown(void);
+
+#endif /* JUNKNAS_HTTP_CLIENT_H */
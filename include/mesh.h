@@ -30,13 +30,24 @@ void junknas_mesh_stop(junknas_mesh_t *mesh);
 int junknas_mesh_fetch_chunk(junknas_mesh_t *mesh, const char *hashhex, const char *dest_path);
 
 /*
- * Replicate a chunk to known mesh peers (best-effort).
- * Returns 0 if dispatched, -1 on error.
+ * Batched fetch: request up to count chunks in one round trip per peer,
+ * writing each received chunk to its dest_paths entry. Peers are tried
+ * best-ranked first; chunks a peer is missing are requested from the next.
+ * Returns the number of chunks fetched, or -1 on error.
+ */
+int junknas_mesh_fetch_chunks(junknas_mesh_t *mesh, int count,
+                              char (*hashes)[65],
+                              char (*dest_paths)[MAX_PATH_LEN]);
+
+/*
+ * Queue a chunk for background replication to mesh peers. The chunk is
+ * referenced by its store path; sender threads read and POST it off the
+ * caller's critical path, with per-peer retry/backoff.
+ * Returns 0 if queued, -1 on error.
  */
 int junknas_mesh_replicate_chunk(junknas_mesh_t *mesh,
                                 const char *hashhex,
-                                const uint8_t *data,
-                                size_t len);
+                                const char *chunk_path);
 
 /*
  * Whether the mesh has at least one active peer.
@@ -0,0 +1,49 @@
+/*
+ * junkNAS - Lightweight operation counters and latency histograms
+ *
+ * Always-on instrumentation for the hot paths: counters and histograms
+ * are striped across cacheline-sized slots updated with relaxed atomics,
+ * so recording a sample is one fetch-add with no locks and (usually) no
+ * cacheline bouncing. Totals are summed at scrape time only. Exported in
+ * Prometheus text format by GET /metrics in the web server.
+ */
+
+#ifndef JUNKNAS_METRICS_H
+#define JUNKNAS_METRICS_H
+
+#include <stdint.h>
+
+typedef enum {
+    JNK_CTR_CHUNK_CACHE_HITS,
+    JNK_CTR_CHUNK_CACHE_MISSES,
+    JNK_CTR_STORE_CHUNKS_WRITTEN,
+    JNK_CTR_STORE_PUT_DEDUP,            /* puts satisfied by an existing chunk */
+    JNK_CTR_FUSE_READ_BYTES,
+    JNK_CTR_FUSE_WRITE_BYTES,
+    JNK_CTR_MESH_FETCH_OK,
+    JNK_CTR_MESH_FETCH_FAIL,
+    JNK_CTR_MESH_CHUNKS_SENT,
+    JNK_CTR_COUNT
+} jnk_metric_ctr_t;
+
+typedef enum {
+    JNK_HIST_FUSE_GETATTR,
+    JNK_HIST_FUSE_READ,
+    JNK_HIST_FUSE_WRITE,
+    JNK_HIST_FUSE_RELEASE,
+    JNK_HIST_CHUNK_READ,                /* read_chunk_verified */
+    JNK_HIST_CHUNK_PUT,                 /* store_put_chunk_if_missing */
+    JNK_HIST_MESH_FETCH,
+    JNK_HIST_COUNT
+} jnk_metric_hist_t;
+
+/* Monotonic microseconds; pair two calls around the measured section. */
+uint64_t jnk_metric_now_us(void);
+
+void jnk_metric_add(jnk_metric_ctr_t c, uint64_t v);
+void jnk_metric_observe_us(jnk_metric_hist_t h, uint64_t us);
+
+/* Render everything as Prometheus text exposition. Caller frees. */
+char *jnk_metrics_render(void);
+
+#endif /* JUNKNAS_METRICS_H */
@@ -0,0 +1,56 @@
+#ifndef JUNKNAS_SHA256_H
+#define JUNKNAS_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * SHA-256 for chunk content addressing and integrity checks.
+ *
+ * The compression function is selected once at runtime: SHA-NI on x86-64
+ * and the ARMv8 crypto extensions on aarch64 when the CPU supports them,
+ * otherwise the portable scalar implementation. Callers never see the
+ * difference; the digest is identical either way.
+ */
+
+typedef struct {
+    uint32_t h[8];
+    uint64_t len_bits;
+    uint8_t  buf[64];
+    size_t   buf_len;
+} sha256_ctx;
+
+/**
+ * Initialize a hashing context (also triggers one-time implementation
+ * selection).
+ */
+void sha256_init(sha256_ctx *c);
+
+/**
+ * Absorb n bytes of data into the context.
+ */
+void sha256_update(sha256_ctx *c, const void *data, size_t n);
+
+/**
+ * Finalize and write the 32-byte digest. The context must be
+ * re-initialized before reuse.
+ */
+void sha256_final(sha256_ctx *c, uint8_t out[32]);
+
+/**
+ * Render a 32-byte digest as lowercase hex (64 chars + NUL).
+ */
+void sha256_hex(const uint8_t digest[32], char hex[65]);
+
+/**
+ * One-shot convenience: hash a buffer and render the digest as hex.
+ */
+void sha256_buf_hex(const void *data, size_t n, char hex[65]);
+
+/**
+ * Name of the selected compression implementation ("sha-ni", "armv8-ce"
+ * or "scalar"); for verbose startup logging.
+ */
+const char *sha256_impl_name(void);
+
+#endif /* JUNKNAS_SHA256_H */
@@ -90,6 +90,7 @@ typedef struct wg_device {
 #define wg_for_each_allowedip(__peer, __allowedip) for ((__allowedip) = (__peer)->first_allowedip; (__allowedip); (__allowedip) = (__allowedip)->next_allowedip)
 
 int wg_set_device(wg_device *dev);
+int wg_sync_device(wg_device *dev); /* diff against kernel state, apply only the changes */
 int wg_get_device(wg_device **dev, const char *device_name);
 int wg_add_device(const char *device_name);
 int wg_del_device(const char *device_name);
@@ -0,0 +1,323 @@
+/*
+ * junkNAS - performance benchmark harness
+ *
+ * `make bench` builds bin/bench and runs it. Each benchmark prints one
+ * machine-readable line:
+ *
+ *   bench=<name> ops=<n> bytes=<n> mb_s=<x> p50_us=<x> p99_us=<x>
+ *
+ * For A/B comparison, save the output of the baseline build and pass it
+ * to the candidate build:
+ *
+ *   git checkout before && make && bin/bench > /tmp/before.txt
+ *   git checkout after  && make && bin/bench --baseline /tmp/before.txt
+ *
+ * Lines whose bench= name matches the baseline gain mb_s_base= and
+ * mb_s_delta_pct= columns, so a regression is one grep away.
+ *
+ * Covered: sha256 hashing, content-defined chunking, LZ4 chunk encode,
+ * and chunk POST/GET against a real junknas_web_server_start() instance
+ * on loopback writing to a throwaway store directory. The FUSE ops
+ * themselves are measured in production by GET /metrics; this harness
+ * sticks to what a build box can run unprivileged.
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "chunker.h"
+#include "compress.h"
+#include "config.h"
+#include "http_client.h"
+#include "sha256.h"
+#include "web_server.h"
+
+#define BENCH_CHUNK       (1024 * 1024)
+#define BENCH_HASH_OPS    256
+#define BENCH_LZ4_OPS     128
+#define BENCH_HTTP_OPS    64
+#define BENCH_CDC_BUF     (32 * 1024 * 1024)
+#define BENCH_WEB_PORT    18473
+
+/* Parsed baseline lines for --baseline A/B output */
+typedef struct {
+    char name[64];
+    double mb_s;
+    double p50_us;
+    double p99_us;
+} bench_base_t;
+
+static bench_base_t base_lines[64];
+static int base_count;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static void fill_random(uint8_t *buf, size_t len) {
+    for (size_t i = 0; i + 8 <= len; i += 8) {
+        uint64_t v = rng_next();
+        memcpy(buf + i, &v, 8);
+    }
+    for (size_t i = len - (len % 8); i < len; i++) buf[i] = (uint8_t)rng_next();
+}
+
+/* Log-like text: the compressible shape chunk payloads actually take */
+static void fill_text(uint8_t *buf, size_t len) {
+    size_t off = 0;
+    int i = 0;
+    while (off + 80 < len) {
+        off += (size_t)snprintf((char *)buf + off, 80,
+            "2026-08-27T12:00:%02d INFO mesh: peer sync round %d complete, 12 chunks\n",
+            i % 60, i);
+        i++;
+    }
+    memset(buf + off, 'x', len - off);
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(uint64_t *lat, size_t n, int pct) {
+    if (n == 0) return 0.0;
+    size_t idx = ((n - 1) * (size_t)pct) / 100;
+    return (double)lat[idx];
+}
+
+static void load_baseline(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "bench: cannot read baseline %s\n", path);
+        exit(2);
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), f) &&
+           base_count < (int)(sizeof(base_lines) / sizeof(base_lines[0]))) {
+        bench_base_t *b = &base_lines[base_count];
+        if (sscanf(line, "bench=%63s ops=%*s bytes=%*s mb_s=%lf p50_us=%lf p99_us=%lf",
+                   b->name, &b->mb_s, &b->p50_us, &b->p99_us) == 4) {
+            base_count++;
+        }
+    }
+    fclose(f);
+}
+
+static const bench_base_t *find_baseline(const char *name) {
+    for (int i = 0; i < base_count; i++) {
+        if (strcmp(base_lines[i].name, name) == 0) return &base_lines[i];
+    }
+    return NULL;
+}
+
+/* Sorts lat in place */
+static void report(const char *name, size_t ops, size_t bytes,
+                   uint64_t total_us, uint64_t *lat, size_t lat_n) {
+    qsort(lat, lat_n, sizeof(*lat), cmp_u64);
+    double mb_s = total_us ? ((double)bytes / (1024.0 * 1024.0)) /
+                             ((double)total_us / 1e6)
+                           : 0.0;
+    double p50 = percentile_us(lat, lat_n, 50);
+    double p99 = percentile_us(lat, lat_n, 99);
+
+    printf("bench=%s ops=%zu bytes=%zu mb_s=%.1f p50_us=%.0f p99_us=%.0f",
+           name, ops, bytes, mb_s, p50, p99);
+    const bench_base_t *b = find_baseline(name);
+    if (b && b->mb_s > 0.0) {
+        printf(" mb_s_base=%.1f mb_s_delta_pct=%+.1f p50_us_base=%.0f p99_us_base=%.0f",
+               b->mb_s, (mb_s - b->mb_s) / b->mb_s * 100.0, b->p50_us, b->p99_us);
+    }
+    printf("\n");
+}
+
+static void bench_sha256(uint8_t *buf) {
+    uint64_t lat[BENCH_HASH_OPS];
+    char hex[65];
+    fill_random(buf, BENCH_CHUNK);
+
+    uint64_t start = now_us();
+    for (int i = 0; i < BENCH_HASH_OPS; i++) {
+        memcpy(buf, &i, sizeof(i)); /* unique content per op */
+        uint64_t t0 = now_us();
+        sha256_buf_hex(buf, BENCH_CHUNK, hex);
+        lat[i] = now_us() - t0;
+    }
+    report("sha256_1m", BENCH_HASH_OPS, (size_t)BENCH_HASH_OPS * BENCH_CHUNK,
+           now_us() - start, lat, BENCH_HASH_OPS);
+}
+
+static void bench_cdc(void) {
+    jnk_cdc_params_t p;
+    if (jnk_cdc_params_init(&p, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024) != 0) return;
+
+    uint8_t *buf = malloc(BENCH_CDC_BUF);
+    if (!buf) return;
+    fill_random(buf, BENCH_CDC_BUF);
+
+    uint64_t lat[512];
+    size_t lat_n = 0, ops = 0;
+    uint64_t start = now_us();
+    size_t off = 0;
+    while (off < BENCH_CDC_BUF) {
+        uint64_t t0 = now_us();
+        size_t n = jnk_cdc_next_boundary(&p, buf + off, BENCH_CDC_BUF - off);
+        if (lat_n < sizeof(lat) / sizeof(lat[0])) lat[lat_n++] = now_us() - t0;
+        if (n == 0) break;
+        off += n;
+        ops++;
+    }
+    report("cdc_chunking", ops, BENCH_CDC_BUF, now_us() - start, lat, lat_n);
+    free(buf);
+}
+
+static void bench_lz4(uint8_t *buf, const char *name, int text) {
+    uint64_t lat[BENCH_LZ4_OPS];
+    if (text) fill_text(buf, BENCH_CHUNK);
+    else fill_random(buf, BENCH_CHUNK);
+
+    uint64_t start = now_us();
+    for (int i = 0; i < BENCH_LZ4_OPS; i++) {
+        uint8_t *enc = NULL;
+        size_t enc_len = 0;
+        uint64_t t0 = now_us();
+        int rc = jnk_chunk_encode(buf, BENCH_CHUNK, &enc, &enc_len);
+        lat[i] = now_us() - t0;
+        if (rc > 0) free(enc);
+    }
+    report(name, BENCH_LZ4_OPS, (size_t)BENCH_LZ4_OPS * BENCH_CHUNK,
+           now_us() - start, lat, BENCH_LZ4_OPS);
+}
+
+static void rm_rf(const char *path) {
+    DIR *d = opendir(path);
+    if (d) {
+        struct dirent *de;
+        while ((de = readdir(d)) != NULL) {
+            if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) continue;
+            char sub[MAX_PATH_LEN];
+            if (snprintf(sub, sizeof(sub), "%s/%s", path, de->d_name) >= (int)sizeof(sub)) continue;
+            struct stat st;
+            if (lstat(sub, &st) == 0 && S_ISDIR(st.st_mode)) rm_rf(sub);
+            else (void)unlink(sub);
+        }
+        closedir(d);
+    }
+    (void)rmdir(path);
+}
+
+/* Chunk POST then GET against a real web server on loopback. The store
+ * write path (shard dirs, tmp+rename) and the sendfile read path are the
+ * same code a mesh peer exercises. */
+static void bench_http(uint8_t *buf) {
+    char tmpl[] = "/tmp/jnkbench-XXXXXX";
+    char *dir = mkdtemp(tmpl);
+    if (!dir) {
+        fprintf(stderr, "bench: mkdtemp failed, skipping http benchmarks\n");
+        return;
+    }
+
+    junknas_config_t *cfg = calloc(1, sizeof(*cfg));
+    if (!cfg) { rm_rf(dir); return; }
+    if (junknas_config_init(cfg, NULL) != 0) {
+        fprintf(stderr, "bench: config init failed, skipping http benchmarks\n");
+        free(cfg);
+        rm_rf(dir);
+        return;
+    }
+    snprintf(cfg->data_dir, sizeof(cfg->data_dir), "%s", dir);
+    snprintf(cfg->data_dirs[0], sizeof(cfg->data_dirs[0]), "%s", dir);
+    cfg->data_dir_count = 1;
+    cfg->web_port = BENCH_WEB_PORT;
+    cfg->verbose = 0;
+
+    junknas_web_server_t *web = junknas_web_server_start(cfg);
+    if (!web) {
+        fprintf(stderr, "bench: web server failed on port %d, skipping http benchmarks\n",
+                BENCH_WEB_PORT);
+        free(cfg);
+        rm_rf(dir);
+        return;
+    }
+
+    char hashes[BENCH_HTTP_OPS][65];
+    uint64_t lat[BENCH_HTTP_OPS];
+    char request[512];
+    int posted = 0;
+
+    uint64_t start = now_us();
+    for (int i = 0; i < BENCH_HTTP_OPS; i++) {
+        fill_random(buf, BENCH_CHUNK);
+        sha256_buf_hex(buf, BENCH_CHUNK, hashes[i]);
+        snprintf(request, sizeof(request),
+                 "POST /chunks/%.64s HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: keep-alive\r\nContent-Length: %d\r\n\r\n",
+                 hashes[i], BENCH_CHUNK);
+        uint64_t t0 = now_us();
+        int rc = junknas_http_request(cfg, "127.0.0.1", BENCH_WEB_PORT,
+                                      request, buf, BENCH_CHUNK, NULL, NULL);
+        lat[i] = now_us() - t0;
+        if (rc == 0) posted++;
+    }
+    report("chunk_post_1m", (size_t)posted, (size_t)posted * BENCH_CHUNK,
+           now_us() - start, lat, BENCH_HTTP_OPS);
+
+    FILE *sink = fopen("/dev/null", "wb");
+    int got = 0;
+    start = now_us();
+    for (int i = 0; i < BENCH_HTTP_OPS; i++) {
+        snprintf(request, sizeof(request),
+                 "GET /chunks/%.64s HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: keep-alive\r\n\r\n",
+                 hashes[i]);
+        uint64_t t0 = now_us();
+        int rc = junknas_http_request(cfg, "127.0.0.1", BENCH_WEB_PORT,
+                                      request, NULL, 0, sink, NULL);
+        lat[i] = now_us() - t0;
+        if (rc == 0) got++;
+    }
+    report("chunk_get_1m", (size_t)got, (size_t)got * BENCH_CHUNK,
+           now_us() - start, lat, BENCH_HTTP_OPS);
+    if (sink) fclose(sink);
+
+    junknas_web_server_stop(web);
+    junknas_http_client_shutdown();
+    free(cfg);
+    rm_rf(dir);
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "--baseline") == 0) {
+        load_baseline(argv[2]);
+    } else if (argc != 1) {
+        fprintf(stderr, "Usage: %s [--baseline <saved bench output>]\n", argv[0]);
+        return 2;
+    }
+
+    uint8_t *buf = malloc(BENCH_CHUNK);
+    if (!buf) return 1;
+
+    printf("bench=meta sha256_impl=%s chunk_bytes=%d\n",
+           sha256_impl_name(), BENCH_CHUNK);
+    bench_sha256(buf);
+    bench_cdc();
+    bench_lz4(buf, "lz4_encode_text", 1);
+    bench_lz4(buf, "lz4_encode_random", 0);
+    bench_http(buf);
+
+    free(buf);
+    return 0;
+}
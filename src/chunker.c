@@ -0,0 +1,86 @@
+/*
+ * junkNAS - Content-defined chunking (FastCDC-style)
+ *
+ * See include/chunker.h for the interface. The gear table is generated
+ * once from a fixed-seed splitmix64 sequence so every node derives the
+ * same boundaries for the same bytes.
+ */
+
+#include "chunker.h"
+
+#include <pthread.h>
+
+/* ---------------------------- Gear table ------------------------------- */
+
+static uint64_t gear_table[256];
+static pthread_once_t gear_once = PTHREAD_ONCE_INIT;
+
+static void gear_init(void) {
+    /* splitmix64 with a fixed seed; the exact constants only matter in
+     * that they never change, or stored chunk boundaries would shift. */
+    uint64_t x = 0x6a6e6b4e41530001ULL;   /* "jnkNAS" + version */
+    for (int i = 0; i < 256; i++) {
+        x += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = x;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        gear_table[i] = z ^ (z >> 31);
+    }
+}
+
+/* ------------------------------ Params --------------------------------- */
+
+/* Round up to the nearest power of two, for mask derivation. */
+static uint64_t pow2_ceil(uint64_t v) {
+    uint64_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+static int mask_bits(uint64_t pow2) {
+    int bits = 0;
+    while (pow2 > 1) { pow2 >>= 1; bits++; }
+    return bits;
+}
+
+int jnk_cdc_params_init(jnk_cdc_params_t *p, size_t min_bytes, size_t avg_bytes, size_t max_bytes) {
+    if (!p) return -1;
+    if (min_bytes == 0 || min_bytes > avg_bytes || avg_bytes > max_bytes) return -1;
+
+    pthread_once(&gear_once, gear_init);
+
+    p->min_bytes = min_bytes;
+    p->avg_bytes = avg_bytes;
+    p->max_bytes = max_bytes;
+
+    /* Normalized chunking: two extra mask bits below the average target
+     * make early cuts rare, two fewer above it make late cuts likely. */
+    int bits = mask_bits(pow2_ceil((uint64_t)avg_bytes));
+    int bits_s = bits + 2;
+    int bits_l = (bits > 2) ? bits - 2 : 1;
+    p->mask_s = (bits_s >= 64) ? ~0ULL : ((1ULL << bits_s) - 1);
+    p->mask_l = (1ULL << bits_l) - 1;
+    return 0;
+}
+
+/* ----------------------------- Boundary -------------------------------- */
+
+size_t jnk_cdc_next_boundary(const jnk_cdc_params_t *p, const uint8_t *data, size_t len) {
+    if (!p || !data || len == 0) return 0;
+    if (len <= p->min_bytes) return len;
+
+    size_t limit = (len < p->max_bytes) ? len : p->max_bytes;
+    size_t mid = (p->avg_bytes < limit) ? p->avg_bytes : limit;
+    uint64_t fp = 0;
+    size_t i = p->min_bytes;
+
+    for (; i < mid; i++) {
+        fp = (fp << 1) + gear_table[data[i]];
+        if ((fp & p->mask_s) == 0) return i + 1;
+    }
+    for (; i < limit; i++) {
+        fp = (fp << 1) + gear_table[data[i]];
+        if ((fp & p->mask_l) == 0) return i + 1;
+    }
+    return limit;
+}
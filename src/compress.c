@@ -0,0 +1,266 @@
+/*
+ * junkNAS - Transparent chunk compression
+ *
+ * See include/compress.h for the interface. The LZ4 block codec below is
+ * a plain greedy matcher: a 4-byte hash table finds candidates within
+ * the 64 KiB window, matches extend backwards over pending literals, and
+ * sequences follow the LZ4 block layout (token, literals, little-endian
+ * offset, extended lengths in 255-byte steps). The decoder validates
+ * every length and offset against its buffers, so a corrupt store file
+ * fails decode instead of overrunning.
+ */
+
+#include "compress.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------------------------- Entropy probe ----------------------------- */
+
+int jnk_compress_probe(const uint8_t *data, size_t len) {
+    if (!data || len < 64) return 0;
+
+    /* Strided sample keeps the probe O(16K) for any chunk size */
+    size_t sample = (len < 16384) ? len : 16384;
+    size_t stride = len / sample;
+    if (stride == 0) stride = 1;
+
+    uint32_t hist[256];
+    memset(hist, 0, sizeof(hist));
+    size_t n = 0;
+    for (size_t i = 0; i < len && n < sample; i += stride, n++) hist[data[i]]++;
+
+    double entropy = 0.0;
+    for (int i = 0; i < 256; i++) {
+        if (hist[i] == 0) continue;
+        double p = (double)hist[i] / (double)n;
+        entropy -= p * log2(p);
+    }
+
+    /* Encrypted and already-compressed data sits at ~8 bits/byte; text
+     * and logs well under 6. The gate errs towards trying. */
+    return entropy < 7.5;
+}
+
+/* ------------------------------ LZ4 block ------------------------------ */
+
+#define LZ4_HASH_LOG 13
+#define LZ4_MINMATCH 4
+
+static uint32_t lz4_read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t lz4_hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ4_HASH_LOG);
+}
+
+/* Compress src into dst; returns the compressed size, or 0 when the
+ * output would not fit in cap (the caller then stores raw). */
+static size_t lz4_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+    if (len < 16) return 0;
+
+    uint32_t table[1 << LZ4_HASH_LOG]; /* position + 1 */
+    memset(table, 0, sizeof(table));
+
+    const size_t mflimit = len - 12;    /* last match starts before this */
+    const size_t matchlimit = len - 5;  /* last 5 bytes stay literals */
+    size_t anchor = 0, ip = 1, op = 0;
+
+    while (ip < mflimit) {
+        uint32_t seq = lz4_read32(src + ip);
+        uint32_t hsh = lz4_hash(seq);
+        size_t cand = table[hsh];
+        table[hsh] = (uint32_t)(ip + 1);
+
+        if (cand == 0 || ip + 1 - cand > 65535 ||
+            lz4_read32(src + cand - 1) != seq) {
+            ip++;
+            continue;
+        }
+        size_t match = cand - 1;
+
+        /* Fold pending literals into the match where they agree */
+        while (ip > anchor && match > 0 && src[ip - 1] == src[match - 1]) {
+            ip--;
+            match--;
+        }
+
+        size_t mlen = LZ4_MINMATCH;
+        while (ip + mlen < matchlimit && src[ip + mlen] == src[match + mlen]) mlen++;
+
+        size_t lit = ip - anchor;
+        size_t off = ip - match;
+
+        if (op + 1 + lit / 255 + 1 + lit + 2 > cap) return 0;
+        size_t tok = op++;
+        if (lit >= 15) {
+            dst[tok] = 0xf0;
+            size_t rest = lit - 15;
+            while (rest >= 255) { dst[op++] = 255; rest -= 255; }
+            dst[op++] = (uint8_t)rest;
+        } else {
+            dst[tok] = (uint8_t)(lit << 4);
+        }
+        memcpy(dst + op, src + anchor, lit);
+        op += lit;
+
+        dst[op++] = (uint8_t)(off & 0xff);
+        dst[op++] = (uint8_t)(off >> 8);
+
+        size_t mcode = mlen - LZ4_MINMATCH;
+        if (mcode >= 15) {
+            dst[tok] |= 0x0f;
+            size_t rest = mcode - 15;
+            if (op + rest / 255 + 1 > cap) return 0;
+            while (rest >= 255) { dst[op++] = 255; rest -= 255; }
+            dst[op++] = (uint8_t)rest;
+        } else {
+            dst[tok] |= (uint8_t)mcode;
+        }
+
+        ip += mlen;
+        anchor = ip;
+    }
+
+    /* Trailing literals close the block (no offset after the last token) */
+    size_t lit = len - anchor;
+    if (op + 1 + lit / 255 + 1 + lit > cap) return 0;
+    size_t tok = op++;
+    if (lit >= 15) {
+        dst[tok] = 0xf0;
+        size_t rest = lit - 15;
+        while (rest >= 255) { dst[op++] = 255; rest -= 255; }
+        dst[op++] = (uint8_t)rest;
+    } else {
+        dst[tok] = (uint8_t)(lit << 4);
+    }
+    memcpy(dst + op, src + anchor, lit);
+    op += lit;
+
+    return op;
+}
+
+/* Safe decompress: every read and write is bounds-checked. Returns 0 on
+ * success with *out_len set, -1 on malformed input. */
+static int lz4_decompress(const uint8_t *src, size_t slen,
+                          uint8_t *dst, size_t cap, size_t *out_len) {
+    size_t ip = 0, op = 0;
+
+    while (ip < slen) {
+        uint8_t token = src[ip++];
+
+        size_t lit = token >> 4;
+        if (lit == 15) {
+            uint8_t b;
+            do {
+                if (ip >= slen) return -1;
+                b = src[ip++];
+                lit += b;
+            } while (b == 255);
+        }
+        if (lit > slen - ip || lit > cap - op) return -1;
+        memcpy(dst + op, src + ip, lit);
+        ip += lit;
+        op += lit;
+
+        if (ip == slen) break; /* last sequence carries no match */
+
+        if (slen - ip < 2) return -1;
+        size_t off = (size_t)src[ip] | ((size_t)src[ip + 1] << 8);
+        ip += 2;
+        if (off == 0 || off > op) return -1;
+
+        size_t mlen = (size_t)(token & 0x0f) + LZ4_MINMATCH;
+        if ((token & 0x0f) == 15) {
+            uint8_t b;
+            do {
+                if (ip >= slen) return -1;
+                b = src[ip++];
+                mlen += b;
+            } while (b == 255);
+        }
+        if (mlen > cap - op) return -1;
+
+        /* Byte copy: matches may overlap their own output */
+        for (size_t i = 0; i < mlen; i++, op++) dst[op] = dst[op - off];
+    }
+
+    *out_len = op;
+    return 0;
+}
+
+/* ----------------------------- Chunk wrapper ---------------------------- */
+
+int jnk_chunk_encode(const uint8_t *data, size_t len, uint8_t **out, size_t *out_len) {
+    int magic_prefix = (len >= 4 && memcmp(data, JNK_COMP_MAGIC, 4) == 0);
+
+    if (len > 4 * sizeof(jnk_comp_hdr_t) && jnk_compress_probe(data, len)) {
+        /* Only a real win counts: beat raw by the header plus ~1.5% */
+        size_t cap = len - sizeof(jnk_comp_hdr_t) - len / 64;
+        uint8_t *buf = (uint8_t *)malloc(sizeof(jnk_comp_hdr_t) + cap);
+        if (!buf) return -1;
+
+        size_t clen = lz4_compress(data, len, buf + sizeof(jnk_comp_hdr_t), cap);
+        if (clen > 0) {
+            jnk_comp_hdr_t hdr;
+            memset(&hdr, 0, sizeof(hdr));
+            memcpy(hdr.magic, JNK_COMP_MAGIC, 4);
+            hdr.codec = JNK_COMP_LZ4;
+            hdr.raw_len = (uint64_t)len;
+            memcpy(buf, &hdr, sizeof(hdr));
+            *out = buf;
+            *out_len = sizeof(hdr) + clen;
+            return 1;
+        }
+        free(buf);
+    }
+
+    if (magic_prefix) {
+        /* Data that masquerades as a wrapper gets wrapped verbatim */
+        uint8_t *buf = (uint8_t *)malloc(sizeof(jnk_comp_hdr_t) + len);
+        if (!buf) return -1;
+        jnk_comp_hdr_t hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, JNK_COMP_MAGIC, 4);
+        hdr.codec = JNK_COMP_RAW;
+        hdr.raw_len = (uint64_t)len;
+        memcpy(buf, &hdr, sizeof(hdr));
+        memcpy(buf + sizeof(hdr), data, len);
+        *out = buf;
+        *out_len = sizeof(hdr) + len;
+        return 1;
+    }
+
+    return 0;
+}
+
+int jnk_chunk_decode(const uint8_t *file, size_t file_len,
+                     uint8_t *out, size_t out_cap, size_t *out_len) {
+    jnk_comp_hdr_t hdr;
+    if (file_len < sizeof(hdr)) return 0;
+    memcpy(&hdr, file, sizeof(hdr));
+    if (memcmp(hdr.magic, JNK_COMP_MAGIC, 4) != 0) return 0;
+
+    if (hdr.raw_len > (uint64_t)out_cap) return -1;
+    const uint8_t *payload = file + sizeof(hdr);
+    size_t plen = file_len - sizeof(hdr);
+
+    if (hdr.codec == JNK_COMP_RAW) {
+        if ((uint64_t)plen != hdr.raw_len) return -1;
+        memcpy(out, payload, plen);
+        *out_len = plen;
+        return 1;
+    }
+    if (hdr.codec == JNK_COMP_LZ4) {
+        size_t dlen = 0;
+        if (lz4_decompress(payload, plen, out, (size_t)hdr.raw_len, &dlen) != 0) return -1;
+        if ((uint64_t)dlen != hdr.raw_len) return -1;
+        *out_len = dlen;
+        return 1;
+    }
+    return -1;
+}
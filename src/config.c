@@ -741,6 +741,16 @@ void junknas_config_cleanup(junknas_config_t *config) {
     /* Currently everything is fixed-size buffers, so nothing to free.
      */
     if (config) {
+        junknas_config_saver_stop(config);
+        pthread_cond_destroy(&config->save_cond);
+        pthread_mutex_destroy(&config->save_lock);
+        pthread_mutex_lock(&config->snapshot_lock);
+        junknas_config_snapshot_t *snap = config->snapshot;
+        config->snapshot = NULL;
+        int drop = (snap && --snap->refs == 0);
+        pthread_mutex_unlock(&config->snapshot_lock);
+        if (drop) free(snap);
+        pthread_mutex_destroy(&config->snapshot_lock);
         pthread_mutex_destroy(&config->lock);
     }
 }
@@ -755,6 +765,213 @@ void junknas_config_unlock(junknas_config_t *config) {
     pthread_mutex_unlock(&config->lock);
 }
 
+/* ------------------------- Read-mostly snapshots -------------------------
+ *
+ * A snapshot is an immutable heap copy of the peer/mount tables. The
+ * published pointer and every snapshot's refcount are guarded by
+ * snapshot_lock, whose critical sections are a pointer swap or a
+ * counter bump — so readers never wait behind a writer rebuilding the
+ * tables or a peer sync serializing them to JSON. Lock order where both
+ * are needed is config->lock then snapshot_lock.
+ */
+
+void junknas_config_publish(junknas_config_t *config) {
+    if (!config) return;
+
+    junknas_config_snapshot_t *fresh = calloc(1, sizeof(*fresh));
+    if (!fresh) return;
+
+    junknas_config_lock(config);
+    (void)safe_strcpy(fresh->node_state, sizeof(fresh->node_state), config->node_state);
+    fresh->web_port = config->web_port;
+    fresh->wg = config->wg;
+
+    fresh->bootstrap_peer_count = config->bootstrap_peer_count;
+    fresh->bootstrap_peers_updated_at = config->bootstrap_peers_updated_at;
+    for (int i = 0; i < config->bootstrap_peer_count && i < MAX_BOOTSTRAP_PEERS; i++) {
+        (void)safe_strcpy(fresh->bootstrap_peers[i], sizeof(fresh->bootstrap_peers[i]),
+                          config->bootstrap_peers[i]);
+        fresh->bootstrap_peer_status[i] = config->bootstrap_peer_status[i];
+    }
+
+    fresh->wg_peer_count = config->wg_peer_count;
+    fresh->wg_peers_updated_at = config->wg_peers_updated_at;
+    for (int i = 0; i < config->wg_peer_count && i < MAX_WG_PEERS; i++) {
+        fresh->wg_peers[i] = config->wg_peers[i];
+        fresh->wg_peer_status[i] = config->wg_peer_status[i];
+    }
+
+    fresh->data_mount_point_count = config->data_mount_point_count;
+    fresh->data_mount_points_updated_at = config->data_mount_points_updated_at;
+    for (int i = 0; i < config->data_mount_point_count && i < MAX_DATA_MOUNT_POINTS; i++) {
+        (void)safe_strcpy(fresh->data_mount_points[i], sizeof(fresh->data_mount_points[i]),
+                          config->data_mount_points[i]);
+    }
+    junknas_config_unlock(config);
+
+    fresh->refs = 1;                   /* the published reference */
+    fresh->owner = config;
+
+    pthread_mutex_lock(&config->snapshot_lock);
+    junknas_config_snapshot_t *old = config->snapshot;
+    config->snapshot = fresh;
+    int drop = (old && --old->refs == 0);
+    pthread_mutex_unlock(&config->snapshot_lock);
+    if (drop) free(old);
+}
+
+junknas_config_snapshot_t *junknas_config_snapshot_get(junknas_config_t *config) {
+    if (!config) return NULL;
+
+    pthread_mutex_lock(&config->snapshot_lock);
+    junknas_config_snapshot_t *snap = config->snapshot;
+    if (snap) snap->refs++;
+    pthread_mutex_unlock(&config->snapshot_lock);
+    if (snap) return snap;
+
+    /* First reader before any publish: build one now. */
+    junknas_config_publish(config);
+    pthread_mutex_lock(&config->snapshot_lock);
+    snap = config->snapshot;
+    if (snap) snap->refs++;
+    pthread_mutex_unlock(&config->snapshot_lock);
+    return snap;
+}
+
+void junknas_config_snapshot_put(junknas_config_snapshot_t *snap) {
+    if (!snap || !snap->owner) return;
+
+    pthread_mutex_lock(&snap->owner->snapshot_lock);
+    int drop = (--snap->refs == 0);
+    pthread_mutex_unlock(&snap->owner->snapshot_lock);
+    if (drop) free(snap);
+}
+
+/* ------------------------- Debounced persistence -------------------------
+ *
+ * Mesh convergence marks the config dirty on every accepted peer
+ * update; rewriting config.json each time serializes the whole config
+ * under config->lock and stalls everyone contending on it. The saver
+ * thread coalesces marks: it waits out a short debounce window, takes a
+ * private copy of the config under the lock (a memcpy, not a JSON
+ * serialization), and writes the file from the copy with no locks
+ * held. The existing tmp+rename in junknas_config_save keeps the write
+ * atomic. Shutdown flushes pending changes before the thread joins.
+ */
+
+#define CONFIG_SAVE_DEBOUNCE_SEC 3
+
+static void config_log_verbose(const junknas_config_t *config, const char *fmt, ...);
+
+static void config_save_from_copy(junknas_config_t *config) {
+    junknas_config_t *copy = malloc(sizeof(*copy));
+    if (!copy) return;
+
+    junknas_config_lock(config);
+    memcpy(copy, config, sizeof(*copy));
+    junknas_config_unlock(config);
+
+    if (junknas_config_save(copy, copy->config_file_path) != 0) {
+        config_log_verbose(config, "config: background save to %s failed",
+                           copy->config_file_path);
+    } else {
+        config_log_verbose(config, "config: background save to %s done",
+                           copy->config_file_path);
+    }
+    free(copy);
+}
+
+static void *config_saver_thread(void *arg) {
+    junknas_config_t *config = (junknas_config_t *)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&config->save_lock);
+        while (!config->save_dirty && !config->saver_stop) {
+            pthread_cond_wait(&config->save_cond, &config->save_lock);
+        }
+        if (!config->save_dirty) {     /* stopping with nothing pending */
+            pthread_mutex_unlock(&config->save_lock);
+            break;
+        }
+        pthread_mutex_unlock(&config->save_lock);
+
+        /* Debounce: let a burst of peer updates coalesce into one write.
+         * Skipped on shutdown so stop flushes immediately. */
+        for (int i = 0; i < CONFIG_SAVE_DEBOUNCE_SEC && !config->saver_stop; i++) {
+            sleep(1);
+        }
+
+        pthread_mutex_lock(&config->save_lock);
+        config->save_dirty = 0;
+        pthread_mutex_unlock(&config->save_lock);
+
+        config_save_from_copy(config);
+    }
+    return NULL;
+}
+
+void junknas_config_mark_dirty(junknas_config_t *config) {
+    if (!config) return;
+
+    pthread_mutex_lock(&config->save_lock);
+    int running = config->saver_running;
+    config->save_dirty = 1;
+    if (running) pthread_cond_signal(&config->save_cond);
+    pthread_mutex_unlock(&config->save_lock);
+
+    if (!running) {
+        /* No saver thread (CLI paths): keep the old synchronous behavior. */
+        junknas_config_lock(config);
+        (void)junknas_config_save(config, config->config_file_path);
+        junknas_config_unlock(config);
+        pthread_mutex_lock(&config->save_lock);
+        config->save_dirty = 0;
+        pthread_mutex_unlock(&config->save_lock);
+    }
+}
+
+int junknas_config_saver_start(junknas_config_t *config) {
+    if (!config) return -1;
+
+    pthread_mutex_lock(&config->save_lock);
+    if (config->saver_running) {
+        pthread_mutex_unlock(&config->save_lock);
+        return 0;
+    }
+    config->saver_stop = 0;
+    pthread_mutex_unlock(&config->save_lock);
+
+    if (pthread_create(&config->saver_thread, NULL, config_saver_thread, config) != 0) {
+        return -1;
+    }
+    pthread_mutex_lock(&config->save_lock);
+    config->saver_running = 1;
+    pthread_mutex_unlock(&config->save_lock);
+    config_log_verbose(config, "config: persistence thread started");
+    return 0;
+}
+
+void junknas_config_saver_stop(junknas_config_t *config) {
+    if (!config) return;
+
+    pthread_mutex_lock(&config->save_lock);
+    if (!config->saver_running) {
+        pthread_mutex_unlock(&config->save_lock);
+        return;
+    }
+    config->saver_stop = 1;
+    pthread_cond_broadcast(&config->save_cond);
+    pthread_mutex_unlock(&config->save_lock);
+
+    pthread_join(config->saver_thread, NULL);
+
+    pthread_mutex_lock(&config->save_lock);
+    config->saver_running = 0;
+    config->saver_stop = 0;
+    pthread_mutex_unlock(&config->save_lock);
+    config_log_verbose(config, "config: persistence thread stopped");
+}
+
 static int wg_peer_equal(const junknas_wg_peer_t *a, const junknas_wg_peer_t *b) {
     if (!a || !b) return 0;
     if (strcmp(a->endpoint, b->endpoint) != 0) return 0;
@@ -834,10 +1051,23 @@ static void set_defaults(junknas_config_t *config) {
     /* This function sets the full config structure to known defaults. */
     memset(config, 0, sizeof(*config));
     pthread_mutex_init(&config->lock, NULL);
+    pthread_mutex_init(&config->snapshot_lock, NULL);
+    pthread_mutex_init(&config->save_lock, NULL);
+    pthread_cond_init(&config->save_cond, NULL);
 
     /* Storage */
     (void)safe_strcpy(config->storage_size, sizeof(config->storage_size), DEFAULT_STORAGE_SIZE);
     config->max_storage_bytes = junknas_parse_storage_size(DEFAULT_STORAGE_SIZE);
+    (void)safe_strcpy(config->chunk_cache_size, sizeof(config->chunk_cache_size), DEFAULT_CHUNK_CACHE_SIZE);
+    config->chunk_cache_bytes = junknas_parse_storage_size(DEFAULT_CHUNK_CACHE_SIZE);
+    (void)safe_strcpy(config->chunking_mode, sizeof(config->chunking_mode), DEFAULT_CHUNKING_MODE);
+    (void)safe_strcpy(config->cdc_min_size, sizeof(config->cdc_min_size), DEFAULT_CDC_MIN_SIZE);
+    (void)safe_strcpy(config->cdc_avg_size, sizeof(config->cdc_avg_size), DEFAULT_CDC_AVG_SIZE);
+    (void)safe_strcpy(config->cdc_max_size, sizeof(config->cdc_max_size), DEFAULT_CDC_MAX_SIZE);
+    config->cdc_min_bytes = junknas_parse_storage_size(DEFAULT_CDC_MIN_SIZE);
+    config->cdc_avg_bytes = junknas_parse_storage_size(DEFAULT_CDC_AVG_SIZE);
+    config->cdc_max_bytes = junknas_parse_storage_size(DEFAULT_CDC_MAX_SIZE);
+    (void)safe_strcpy(config->compression, sizeof(config->compression), DEFAULT_COMPRESSION);
 
     /* Paths */
     (void)junknas_default_data_dir(config->data_dir, sizeof(config->data_dir));
@@ -855,6 +1085,8 @@ static void set_defaults(junknas_config_t *config) {
     /* Runtime flags (sane defaults) */
     config->verbose = 0;
     config->enable_fuse = 1;
+    config->fuse_threads = DEFAULT_FUSE_THREADS;
+    config->commit_workers = DEFAULT_COMMIT_WORKERS;
     config->daemon_mode = 0;
 
     /* WireGuard defaults */
@@ -907,6 +1139,7 @@ int junknas_config_validate(const junknas_config_t *config) {
     if (config->data_dir_count == 0 || config->data_dir_count > MAX_DATA_DIRS) return -1;
     for (size_t i = 0; i < config->data_dir_count; i++) {
         if (config->data_dirs[i][0] == '\0') return -1;
+        if (config->data_dir_tiers[i] < 0 || config->data_dir_tiers[i] > 7) return -1;
     }
     if (config->mount_point[0] == '\0') return -1;
     if (config->wg.interface_name[0] == '\0') return -1;
@@ -914,6 +1147,24 @@ int junknas_config_validate(const junknas_config_t *config) {
     /* Storage: require parse success */
     if (config->max_storage_bytes == 0) return -1;
 
+    /* CDC size targets: ordered, and capped at the 1 MiB store chunk
+     * ceiling so every existing chunk buffer and transfer path holds */
+    if (strcmp(config->chunking_mode, "fixed") != 0 &&
+        strcmp(config->chunking_mode, "cdc") != 0) {
+        return -1;
+    }
+    if (config->cdc_min_bytes == 0 ||
+        config->cdc_min_bytes > config->cdc_avg_bytes ||
+        config->cdc_avg_bytes > config->cdc_max_bytes ||
+        config->cdc_max_bytes > (size_t)(1024 * 1024)) {
+        return -1;
+    }
+
+    if (strcmp(config->compression, "off") != 0 &&
+        strcmp(config->compression, "lz4") != 0) {
+        return -1;
+    }
+
     /* Bootstrap peers count range */
     if (config->bootstrap_peer_count < 0 || config->bootstrap_peer_count > MAX_BOOTSTRAP_PEERS) {
         return -1;
@@ -1071,6 +1322,49 @@ int junknas_config_load(junknas_config_t *config, const char *config_file) {
         if (b != 0) config->max_storage_bytes = b;
     }
 
+    /* chunk_cache_size ("0" is valid and disables the cache) */
+    cJSON *chunk_cache_size = cJSON_GetObjectItemCaseSensitive(root, "chunk_cache_size");
+    if (cJSON_IsString(chunk_cache_size) && chunk_cache_size->valuestring) {
+        (void)safe_strcpy(config->chunk_cache_size, sizeof(config->chunk_cache_size), chunk_cache_size->valuestring);
+        config->chunk_cache_bytes = junknas_parse_storage_size(config->chunk_cache_size);
+    }
+
+    /* chunking_mode + CDC size targets */
+    cJSON *chunking_mode = cJSON_GetObjectItemCaseSensitive(root, "chunking_mode");
+    if (cJSON_IsString(chunking_mode) && chunking_mode->valuestring &&
+        (strcmp(chunking_mode->valuestring, "fixed") == 0 ||
+         strcmp(chunking_mode->valuestring, "cdc") == 0)) {
+        (void)safe_strcpy(config->chunking_mode, sizeof(config->chunking_mode),
+                          chunking_mode->valuestring);
+    }
+    cJSON *cdc_min = cJSON_GetObjectItemCaseSensitive(root, "cdc_min_size");
+    if (cJSON_IsString(cdc_min) && cdc_min->valuestring) {
+        (void)safe_strcpy(config->cdc_min_size, sizeof(config->cdc_min_size), cdc_min->valuestring);
+        size_t b = junknas_parse_storage_size(config->cdc_min_size);
+        if (b != 0) config->cdc_min_bytes = b;
+    }
+    cJSON *cdc_avg = cJSON_GetObjectItemCaseSensitive(root, "cdc_avg_size");
+    if (cJSON_IsString(cdc_avg) && cdc_avg->valuestring) {
+        (void)safe_strcpy(config->cdc_avg_size, sizeof(config->cdc_avg_size), cdc_avg->valuestring);
+        size_t b = junknas_parse_storage_size(config->cdc_avg_size);
+        if (b != 0) config->cdc_avg_bytes = b;
+    }
+    cJSON *cdc_max = cJSON_GetObjectItemCaseSensitive(root, "cdc_max_size");
+    if (cJSON_IsString(cdc_max) && cdc_max->valuestring) {
+        (void)safe_strcpy(config->cdc_max_size, sizeof(config->cdc_max_size), cdc_max->valuestring);
+        size_t b = junknas_parse_storage_size(config->cdc_max_size);
+        if (b != 0) config->cdc_max_bytes = b;
+    }
+
+    /* compression */
+    cJSON *compression = cJSON_GetObjectItemCaseSensitive(root, "compression");
+    if (cJSON_IsString(compression) && compression->valuestring &&
+        (strcmp(compression->valuestring, "off") == 0 ||
+         strcmp(compression->valuestring, "lz4") == 0)) {
+        (void)safe_strcpy(config->compression, sizeof(config->compression),
+                          compression->valuestring);
+    }
+
     /* data_dir */
     cJSON *data_dir = cJSON_GetObjectItemCaseSensitive(root, "data_dir");
     if (cJSON_IsString(data_dir) && data_dir->valuestring) {
@@ -1116,6 +1410,22 @@ int junknas_config_load(junknas_config_t *config, const char *config_file) {
         }
     }
 
+    /* data_dir_tiers: placement hint aligned by index with data_dirs
+     * (0 = fastest). Missing entries stay on the default tier. */
+    cJSON *data_dir_tiers = cJSON_GetObjectItemCaseSensitive(root, "data_dir_tiers");
+    if (cJSON_IsArray(data_dir_tiers)) {
+        int n = cJSON_GetArraySize(data_dir_tiers);
+        if (n > MAX_DATA_DIRS) n = MAX_DATA_DIRS;
+        for (int i = 0; i < n; i++) {
+            cJSON *tier = cJSON_GetArrayItem(data_dir_tiers, i);
+            if (!cJSON_IsNumber(tier)) continue;
+            int v = (int)tier->valuedouble;
+            if (v < 0) v = 0;
+            if (v > 7) v = 7;
+            config->data_dir_tiers[i] = v;
+        }
+    }
+
     /* mount_point */
     cJSON *mount_point = cJSON_GetObjectItemCaseSensitive(root, "mount_point");
     if (cJSON_IsString(mount_point) && mount_point->valuestring) {
@@ -1128,6 +1438,18 @@ int junknas_config_load(junknas_config_t *config, const char *config_file) {
         config->web_port = (uint16_t)web_port->valuedouble;
     }
 
+    /* fuse_threads */
+    cJSON *fuse_threads = cJSON_GetObjectItemCaseSensitive(root, "fuse_threads");
+    if (cJSON_IsNumber(fuse_threads) && fuse_threads->valuedouble >= 0 && fuse_threads->valuedouble <= 256) {
+        config->fuse_threads = (int)fuse_threads->valuedouble;
+    }
+
+    /* commit_workers */
+    cJSON *commit_workers = cJSON_GetObjectItemCaseSensitive(root, "commit_workers");
+    if (cJSON_IsNumber(commit_workers) && commit_workers->valuedouble >= 0 && commit_workers->valuedouble <= 64) {
+        config->commit_workers = (int)commit_workers->valuedouble;
+    }
+
     /* runtime flags */
     cJSON *verbose = cJSON_GetObjectItemCaseSensitive(root, "verbose");
     if (cJSON_IsBool(verbose)) config->verbose = cJSON_IsTrue(verbose) ? 1 : 0;
@@ -1285,6 +1607,12 @@ int junknas_config_save(const junknas_config_t *config, const char *config_file)
 
     /* top-level fields */
     cJSON_AddStringToObject(root, "storage_size", config->storage_size);
+    cJSON_AddStringToObject(root, "chunk_cache_size", config->chunk_cache_size);
+    cJSON_AddStringToObject(root, "chunking_mode", config->chunking_mode);
+    cJSON_AddStringToObject(root, "cdc_min_size", config->cdc_min_size);
+    cJSON_AddStringToObject(root, "cdc_avg_size", config->cdc_avg_size);
+    cJSON_AddStringToObject(root, "cdc_max_size", config->cdc_max_size);
+    cJSON_AddStringToObject(root, "compression", config->compression);
     cJSON_AddStringToObject(root, "data_dir", config->data_dir);
     cJSON *data_dirs_out = cJSON_CreateArray();
     if (!data_dirs_out) {
@@ -1298,8 +1626,19 @@ int junknas_config_save(const junknas_config_t *config, const char *config_file)
         const char *dir = (config->data_dir_count > 0) ? config->data_dirs[i] : config->data_dir;
         cJSON_AddItemToArray(data_dirs_out, cJSON_CreateString(dir));
     }
+    cJSON *data_dir_tiers_out = cJSON_CreateArray();
+    if (!data_dir_tiers_out) {
+        cJSON_Delete(root);
+        return -1;
+    }
+    cJSON_AddItemToObject(root, "data_dir_tiers", data_dir_tiers_out);
+    for (size_t i = 0; i < dir_count && i < MAX_DATA_DIRS; i++) {
+        cJSON_AddItemToArray(data_dir_tiers_out, cJSON_CreateNumber((double)config->data_dir_tiers[i]));
+    }
     cJSON_AddStringToObject(root, "mount_point", config->mount_point);
     cJSON_AddNumberToObject(root, "web_port", (double)config->web_port);
+    cJSON_AddNumberToObject(root, "fuse_threads", (double)config->fuse_threads);
+    cJSON_AddNumberToObject(root, "commit_workers", (double)config->commit_workers);
     cJSON_AddStringToObject(root, "node_state", config->node_state);
 
     cJSON_AddBoolToObject(root, "verbose", config->verbose ? 1 : 0);
@@ -1433,5 +1772,6 @@ int junknas_config_init(junknas_config_t *config, const char *config_file) {
         return -1;
     }
     config_log_verbose(config, "config: validation succeeded");
+    junknas_config_publish(config);
     return 0;
 }
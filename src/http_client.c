@@ -0,0 +1,389 @@
+/*
+ * junkNAS - shared HTTP client with per-peer keep-alive connections
+ *
+ * mesh.c and web_server.c used to open a fresh TCP connection (plus a
+ * getaddrinfo lookup) for every chunk fetch, chunk replicate and peer
+ * sync, and tear it down again after one request. This module keeps a
+ * small pool of idle connections keyed by host:port and reuses them for
+ * HTTP/1.1 requests. Responses with a Content-Length are read to their
+ * exact end so the connection stays usable; responses without one (or
+ * with "Connection: close") fall back to read-until-EOF and the socket
+ * is discarded, so servers that do not speak keep-alive still work.
+ */
+
+#include "http_client.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#define HTTP_POOL_SIZE            8    /* idle connections kept across all peers */
+#define HTTP_POOL_IDLE_TIMEOUT_SEC 30  /* drop idle connections older than this */
+#define HTTP_IO_TIMEOUT_SEC       5    /* per-socket send/recv timeout */
+#define HTTP_HEADER_MAX           8192
+
+static void http_log_verbose(const junknas_config_t *config, const char *fmt, ...) {
+    if (!config || !config->verbose) return;
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+/* ------------------------- Connection pool ------------------------- */
+
+typedef struct {
+    char host[MAX_ENDPOINT_LEN];
+    uint16_t port;
+    int fd;                            /* -1 when the slot is empty */
+    time_t last_used;
+} http_pool_slot_t;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static http_pool_slot_t pool_slots[HTTP_POOL_SIZE];
+static int pool_initialized = 0;
+
+/* Caller holds pool_lock */
+static void pool_init_locked(void) {
+    if (pool_initialized) return;
+    for (int i = 0; i < HTTP_POOL_SIZE; i++) {
+        pool_slots[i].fd = -1;
+    }
+    pool_initialized = 1;
+}
+
+static int resolve_addr(const char *host, uint16_t port,
+                        struct sockaddr_storage *out, socklen_t *out_len) {
+    if (!host || !out || !out_len) return -1;
+    char port_str[8];
+    snprintf(port_str, sizeof(port_str), "%u", port);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_family = AF_UNSPEC;
+
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(host, port_str, &hints, &res) != 0) return -1;
+
+    if (!res) return -1;
+    memcpy(out, res->ai_addr, res->ai_addrlen);
+    *out_len = (socklen_t)res->ai_addrlen;
+    freeaddrinfo(res);
+    return 0;
+}
+
+static int pool_connect(const junknas_config_t *config, const char *host, uint16_t port) {
+    struct sockaddr_storage addr;
+    socklen_t addr_len = 0;
+    if (resolve_addr(host, port, &addr, &addr_len) != 0) {
+        http_log_verbose(config, "http: resolve failed for %s:%u", host, port);
+        return -1;
+    }
+
+    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        http_log_verbose(config, "http: socket create failed for %s:%u", host, port);
+        return -1;
+    }
+
+    struct timeval timeout;
+    timeout.tv_sec = HTTP_IO_TIMEOUT_SEC;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    if (connect(fd, (struct sockaddr *)&addr, addr_len) != 0) {
+        http_log_verbose(config, "http: connect failed for %s:%u", host, port);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Take an idle pooled connection for host:port, or open a new one.
+ * Sets *reused so the caller knows a dead socket may just be stale. */
+static int pool_acquire(const junknas_config_t *config, const char *host, uint16_t port,
+                        int *reused) {
+    *reused = 0;
+    time_t now = time(NULL);
+    int fd = -1;
+
+    pthread_mutex_lock(&pool_lock);
+    pool_init_locked();
+    for (int i = 0; i < HTTP_POOL_SIZE; i++) {
+        http_pool_slot_t *slot = &pool_slots[i];
+        if (slot->fd < 0) continue;
+        if (now - slot->last_used > HTTP_POOL_IDLE_TIMEOUT_SEC) {
+            close(slot->fd);
+            slot->fd = -1;
+            continue;
+        }
+        if (fd < 0 && slot->port == port && strcmp(slot->host, host) == 0) {
+            fd = slot->fd;
+            slot->fd = -1;
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    if (fd >= 0) {
+        http_log_verbose(config, "http: reusing connection to %s:%u", host, port);
+        *reused = 1;
+        return fd;
+    }
+    return pool_connect(config, host, port);
+}
+
+/* Return a connection whose response left it in a reusable state. */
+static void pool_release(const char *host, uint16_t port, int fd) {
+    time_t now = time(NULL);
+    http_pool_slot_t *victim = NULL;
+
+    pthread_mutex_lock(&pool_lock);
+    pool_init_locked();
+    for (int i = 0; i < HTTP_POOL_SIZE; i++) {
+        http_pool_slot_t *slot = &pool_slots[i];
+        if (slot->fd < 0) {
+            victim = slot;
+            break;
+        }
+        if (!victim || slot->last_used < victim->last_used) {
+            victim = slot;
+        }
+    }
+    if (victim->fd >= 0) {
+        close(victim->fd);
+    }
+    snprintf(victim->host, sizeof(victim->host), "%s", host);
+    victim->port = port;
+    victim->fd = fd;
+    victim->last_used = now;
+    pthread_mutex_unlock(&pool_lock);
+}
+
+void junknas_http_client_shutdown(void) {
+    pthread_mutex_lock(&pool_lock);
+    pool_init_locked();
+    for (int i = 0; i < HTTP_POOL_SIZE; i++) {
+        if (pool_slots[i].fd >= 0) {
+            close(pool_slots[i].fd);
+            pool_slots[i].fd = -1;
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
+
+/* ------------------------- Request/response ------------------------- */
+
+/* Response body goes either to a stream or a growing malloc'd buffer. */
+typedef struct {
+    FILE *out_file;
+    char *buf;
+    size_t buf_len;
+    int collect;
+    int failed;
+} http_body_sink_t;
+
+static void sink_emit(http_body_sink_t *sink, const char *data, size_t len) {
+    if (len == 0 || sink->failed) return;
+    if (sink->out_file) {
+        fwrite(data, 1, len, sink->out_file);
+    }
+    if (sink->collect) {
+        char *grown = realloc(sink->buf, sink->buf_len + len + 1);
+        if (!grown) {
+            sink->failed = 1;
+            return;
+        }
+        sink->buf = grown;
+        memcpy(sink->buf + sink->buf_len, data, len);
+        sink->buf_len += len;
+        sink->buf[sink->buf_len] = '\0';
+    }
+}
+
+/* Case-insensitive header lookup in a NUL-terminated header block.
+ * Returns the value with surrounding whitespace trimmed, or -1. */
+static int header_find_value(const char *headers, const char *name,
+                             char *out, size_t out_len) {
+    size_t name_len = strlen(name);
+    const char *line = headers;
+    while (line && *line) {
+        if (strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') {
+            const char *value = line + name_len + 1;
+            while (*value == ' ' || *value == '\t') value++;
+            const char *end = value;
+            while (*end && *end != '\r' && *end != '\n') end++;
+            size_t len = (size_t)(end - value);
+            if (len >= out_len) len = out_len - 1;
+            memcpy(out, value, len);
+            out[len] = '\0';
+            return 0;
+        }
+        line = strstr(line, "\r\n");
+        if (line) line += 2;
+    }
+    return -1;
+}
+
+/*
+ * Send one request and consume one response. Returns 0 when a complete
+ * response was read (any status), -1 on transport failure. Retries once
+ * with a fresh connection when a reused socket turns out to be stale.
+ */
+static int http_do_request(const junknas_config_t *config, const char *host, uint16_t port,
+                           const char *request, const void *body, size_t body_len,
+                           http_body_sink_t *sink, int *out_status) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int reused = 0;
+        int fd = pool_acquire(config, host, port, &reused);
+        if (fd < 0) return -1;
+
+        size_t request_len = strlen(request);
+        http_log_verbose(config, "http: send request %s:%u (%zu bytes)", host, port, request_len);
+        if (send(fd, request, request_len, MSG_NOSIGNAL) < 0) {
+            close(fd);
+            if (reused) continue;
+            http_log_verbose(config, "http: send request failed for %s:%u", host, port);
+            return -1;
+        }
+        if (body && body_len > 0) {
+            if (send(fd, body, body_len, MSG_NOSIGNAL) < 0) {
+                close(fd);
+                if (reused) continue;
+                http_log_verbose(config, "http: send body failed for %s:%u", host, port);
+                return -1;
+            }
+        }
+
+        /* Read until the end of the header block */
+        char header_buf[HTTP_HEADER_MAX + 1];
+        size_t header_used = 0;
+        size_t header_len = 0;
+        while (header_len == 0) {
+            if (header_used >= HTTP_HEADER_MAX) break;
+            ssize_t n = recv(fd, header_buf + header_used,
+                             HTTP_HEADER_MAX - header_used, 0);
+            if (n <= 0) break;
+            header_used += (size_t)n;
+            for (size_t i = 0; i + 3 < header_used; i++) {
+                if (header_buf[i] == '\r' && header_buf[i + 1] == '\n' &&
+                    header_buf[i + 2] == '\r' && header_buf[i + 3] == '\n') {
+                    header_len = i + 4;
+                    break;
+                }
+            }
+        }
+        if (header_len == 0) {
+            close(fd);
+            /* A pooled connection the server closed in the meantime looks
+             * exactly like this; retry once on a fresh socket. */
+            if (reused && header_used == 0) continue;
+            http_log_verbose(config, "http: bad response from %s:%u", host, port);
+            return -1;
+        }
+
+        char saved = header_buf[header_len];
+        header_buf[header_len] = '\0';
+        int status = 0;
+        (void)sscanf(header_buf, "HTTP/%*s %d", &status);
+
+        long long content_len = -1;
+        char value[64];
+        if (header_find_value(header_buf, "Content-Length", value, sizeof(value)) == 0) {
+            char *end = NULL;
+            content_len = strtoll(value, &end, 10);
+            if (end == value || content_len < 0) content_len = -1;
+        }
+        int keep_alive = (strncmp(header_buf, "HTTP/1.1", 8) == 0);
+        if (header_find_value(header_buf, "Connection", value, sizeof(value)) == 0 &&
+            strcasecmp(value, "close") == 0) {
+            keep_alive = 0;
+        }
+        header_buf[header_len] = saved;
+
+        /* Body bytes that arrived with the headers */
+        size_t body_got = header_used - header_len;
+        if (content_len >= 0 && body_got > (size_t)content_len) {
+            body_got = (size_t)content_len;
+        }
+        sink_emit(sink, header_buf + header_len, body_got);
+
+        int complete = 1;
+        if (content_len >= 0) {
+            char buf[4096];
+            while (body_got < (size_t)content_len) {
+                size_t want = (size_t)content_len - body_got;
+                if (want > sizeof(buf)) want = sizeof(buf);
+                ssize_t n = recv(fd, buf, want, 0);
+                if (n <= 0) {
+                    complete = 0;
+                    break;
+                }
+                sink_emit(sink, buf, (size_t)n);
+                body_got += (size_t)n;
+            }
+        } else {
+            /* No length: the server delimits the body by closing */
+            keep_alive = 0;
+            char buf[4096];
+            ssize_t n;
+            while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+                sink_emit(sink, buf, (size_t)n);
+            }
+        }
+
+        if (complete && keep_alive) {
+            pool_release(host, port, fd);
+        } else {
+            close(fd);
+        }
+
+        if (out_status) *out_status = status;
+        http_log_verbose(config, "http: response %s:%u status=%d body=%zu bytes",
+                         host, port, status, body_got);
+        return complete ? 0 : -1;
+    }
+    return -1;
+}
+
+int junknas_http_request(const junknas_config_t *config, const char *host, uint16_t port,
+                         const char *request, const void *body, size_t body_len,
+                         FILE *out, int *out_status) {
+    if (!host || !request) return -1;
+    http_body_sink_t sink = { out, NULL, 0, 0, 0 };
+    int status = 0;
+    if (http_do_request(config, host, port, request, body, body_len, &sink, &status) != 0) {
+        return -1;
+    }
+    if (out_status) *out_status = status;
+    return (status >= 200 && status < 300) ? 0 : -1;
+}
+
+char *junknas_http_request_body(const junknas_config_t *config, const char *host, uint16_t port,
+                                const char *request, const void *body, size_t body_len,
+                                int *out_status) {
+    if (!host || !request) return NULL;
+    http_body_sink_t sink = { NULL, NULL, 0, 1, 0 };
+    int status = 0;
+    if (http_do_request(config, host, port, request, body, body_len, &sink, &status) != 0 ||
+        sink.failed) {
+        free(sink.buf);
+        return NULL;
+    }
+    if (out_status) *out_status = status;
+    if (!sink.buf) {
+        sink.buf = calloc(1, 1);
+    }
+    return sink.buf;
+}
@@ -23,6 +23,7 @@
 #include <time.h>
 #include "config.h"
 #include "fuse_fs.h"
+#include "http_client.h"
 #include "mesh.h"
 #include "web_server.h"
 
@@ -264,6 +265,10 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    if (junknas_config_saver_start(&cfg) != 0) {
+        fprintf(stderr, "Warning: failed to start config saver; saving synchronously.\n");
+    }
+
     log_verbose(cfg.verbose, "startup: establishing mesh");
     junknas_mesh_t *mesh = junknas_mesh_start(&cfg);
     if (!mesh) {
@@ -289,6 +294,8 @@ int main(int argc, char **argv) {
 
     if (web) junknas_web_server_stop(web);
     if (mesh) junknas_mesh_stop(mesh);
+    junknas_config_saver_stop(&cfg);
+    junknas_http_client_shutdown();
 
     return rc;
 }
@@ -4,6 +4,11 @@
 
 #include "mesh.h"
 
+#include "chunk_inventory.h"
+#include "http_client.h"
+#include "metrics.h"
+#include "wireguard.h"
+
 #include <arpa/inet.h>
 #include <errno.h>
 #include <netdb.h>
@@ -28,6 +33,20 @@
 #define MESH_CONNECT_TIMEOUT_SEC 1
 #define MESH_SYNC_INTERVAL_SEC 5
 
+/* Replication queue tuning */
+#define MESH_REPL_SENDERS      2    /* background sender threads */
+#define MESH_REPL_QUEUE_MAX    1024 /* in-memory items before spilling */
+#define MESH_REPL_RETRY_MAX    5    /* attempts per peer before dropping */
+#define MESH_REPL_BACKOFF_CAP  60   /* max retry delay, seconds */
+#define MESH_REPL_BATCH        8    /* due items drained per sender pass */
+
+/* Hedged chunk fetch tuning */
+#define MESH_FETCH_HEDGE       3       /* peers queried concurrently per wave */
+#define MESH_FETCH_BATCH_MAX   256     /* chunks per batched fetch request */
+#define MESH_STAT_ALPHA        0.3     /* EWMA weight of the newest sample */
+#define MESH_STAT_DEFAULT_MS   100.0   /* assumed latency for unranked peers */
+#define MESH_STAT_FAIL_MS      10000.0 /* latency charged for a failed fetch */
+
 static void mesh_log_verbose(const junknas_config_t *config, const char *fmt, ...) {
     if (!config || !config->verbose) return;
     va_list args;
@@ -37,6 +56,50 @@ static void mesh_log_verbose(const junknas_config_t *config, const char *fmt, ..
     va_end(args);
 }
 
+/* Queued replication work. Items reference the chunk by its store path
+ * instead of carrying the payload, so the queue stays small; senders read
+ * the file when they actually transmit. endpoint is empty for the initial
+ * broadcast to all peers, and set on per-peer retry items. */
+typedef struct mesh_repl_item {
+    char hashhex[65];
+    char path[MAX_PATH_LEN];
+    char endpoint[MAX_ENDPOINT_LEN];
+    int attempts;
+    time_t due;                        /* do not send before this time */
+    struct mesh_repl_item *next;
+} mesh_repl_item_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    mesh_repl_item_t *head;
+    mesh_repl_item_t *tail;
+    size_t count;
+    int stop;
+    int started;
+    pthread_t senders[MESH_REPL_SENDERS];
+    char spill_path[MAX_PATH_LEN];     /* overflow + shutdown journal */
+    int spill_nonempty;
+} mesh_repl_t;
+
+/* Per-peer fetch ranking: an EWMA of observed fetch latency, with failed
+ * fetches charged a large fixed cost so dead peers sink to the back. */
+typedef struct {
+    char host[MAX_ENDPOINT_LEN];
+    uint16_t port;
+    double ewma_ms;
+    int samples;
+} mesh_peer_stat_t;
+
+/* Last known copy of a peer's chunk inventory bloom filter (wire format
+ * in chunk_inventory.h). bits stays NULL until the first fetch. */
+typedef struct {
+    char host[MAX_ENDPOINT_LEN];
+    uint16_t port;
+    uint64_t generation;
+    uint8_t *bits;
+} mesh_peer_inv_t;
+
 struct junknas_mesh {
     junknas_config_t *config;
     pthread_t listener;
@@ -47,11 +110,16 @@ struct junknas_mesh {
     uint64_t last_applied_peers_updated_at;
     time_t last_public_ip_check;
     char last_public_ip[64];
+    mesh_repl_t repl;
+    pthread_mutex_t stats_lock;        /* guards stats + fetch_inflight */
+    pthread_cond_t stats_cond;
+    mesh_peer_stat_t stats[MESH_MAX_PEERS];
+    int stat_count;
+    int fetch_inflight;                /* hedge workers still running */
+    mesh_peer_inv_t invs[MESH_MAX_PEERS]; /* also under stats_lock */
+    int inv_count;
 };
 
-static char *http_request_body(const junknas_config_t *config, const char *host, uint16_t port,
-                               const char *request, const char *body, size_t body_len, int *out_status);
-
 static int ensure_config_dir(void) {
     char config_dir[MAX_PATH_LEN];
     if (junknas_default_config_dir(config_dir, sizeof(config_dir)) != 0) {
@@ -166,27 +234,6 @@ static int is_ipv4_address(const char *text) {
     return inet_pton(AF_INET, text, &addr) == 1;
 }
 
-static int resolve_addr(const char *host, uint16_t port, int socktype,
-                        struct sockaddr_storage *out, socklen_t *out_len) {
-    if (!host || !out || !out_len) return -1;
-    char port_str[8];
-    snprintf(port_str, sizeof(port_str), "%u", port);
-
-    struct addrinfo hints;
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_socktype = socktype;
-    hints.ai_family = AF_UNSPEC;
-
-    struct addrinfo *res = NULL;
-    if (getaddrinfo(host, port_str, &hints, &res) != 0) return -1;
-
-    if (!res) return -1;
-    memcpy(out, res->ai_addr, res->ai_addrlen);
-    *out_len = (socklen_t)res->ai_addrlen;
-    freeaddrinfo(res);
-    return 0;
-}
-
 static int fetch_public_ip(const junknas_config_t *config, char *out, size_t out_len) {
     if (!out || out_len == 0) return -1;
     out[0] = '\0';
@@ -199,7 +246,7 @@ static int fetch_public_ip(const junknas_config_t *config, char *out, size_t out
              path, host);
 
     int status = 0;
-    char *body = http_request_body(config, host, 80, request, NULL, 0, &status);
+    char *body = junknas_http_request_body(config, host, 80, request, NULL, 0, &status);
     if (!body) return -1;
 
     int rc = -1;
@@ -259,6 +306,7 @@ static __attribute__((unused)) int mesh_refresh_public_endpoint(struct junknas_m
         snprintf(mesh->last_public_ip, sizeof(mesh->last_public_ip), "%s", public_ip);
     }
     junknas_config_unlock(mesh->config);
+    if (changed) junknas_config_publish(mesh->config);
 
     if (changed) {
         mesh_log_verbose(mesh->config, "mesh: public endpoint updated to %s", endpoint_snapshot);
@@ -267,121 +315,12 @@ static __attribute__((unused)) int mesh_refresh_public_endpoint(struct junknas_m
     }
 
     if (changed) {
-        junknas_config_lock(mesh->config);
-        (void)junknas_config_save(mesh->config, mesh->config->config_file_path);
-        junknas_config_unlock(mesh->config);
+        junknas_config_mark_dirty(mesh->config);
     }
 
     return changed;
 }
 
-static char *http_request_body(const junknas_config_t *config, const char *host, uint16_t port,
-                               const char *request, const char *body, size_t body_len, int *out_status) {
-    struct sockaddr_storage addr;
-    socklen_t addr_len = 0;
-    if (resolve_addr(host, port, SOCK_STREAM, &addr, &addr_len) != 0) {
-        mesh_log_verbose(config, "mesh: http resolve failed for %s:%u", host, port);
-        return NULL;
-    }
-
-    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
-    if (fd < 0) {
-        mesh_log_verbose(config, "mesh: http socket create failed for %s:%u", host, port);
-        return NULL;
-    }
-
-    if (connect(fd, (struct sockaddr *)&addr, addr_len) != 0) {
-        mesh_log_verbose(config, "mesh: http connect failed for %s:%u", host, port);
-        close(fd);
-        return NULL;
-    }
-
-    size_t request_len = strlen(request);
-    mesh_log_verbose(config, "mesh: http send request %s:%u (%zu bytes)", host, port, request_len);
-    if (send(fd, request, request_len, 0) < 0) {
-        mesh_log_verbose(config, "mesh: http send request failed for %s:%u", host, port);
-        close(fd);
-        return NULL;
-    }
-    if (body && body_len > 0) {
-        mesh_log_verbose(config, "mesh: http send body %s:%u (%zu bytes)", host, port, body_len);
-        if (send(fd, body, body_len, 0) < 0) {
-            mesh_log_verbose(config, "mesh: http send body failed for %s:%u", host, port);
-            close(fd);
-            return NULL;
-        }
-    }
-
-    char buf[4096];
-    char header_buf[8192 + 1];
-    size_t header_used = 0;
-    int status = 0;
-    int header_done = 0;
-    char *out = NULL;
-    size_t out_len = 0;
-
-    while (1) {
-        ssize_t n = recv(fd, buf, sizeof(buf), 0);
-        if (n <= 0) break;
-        mesh_log_verbose(config, "mesh: http recv chunk %s:%u (%zd bytes)", host, port, n);
-
-        if (!header_done) {
-            size_t to_copy = (size_t)n;
-            if (header_used + to_copy > sizeof(header_buf)) {
-                to_copy = sizeof(header_buf) - header_used;
-            }
-            memcpy(header_buf + header_used, buf, to_copy);
-            header_used += to_copy;
-
-            char *header_end = NULL;
-            for (size_t i = 0; i + 3 < header_used; i++) {
-                if (header_buf[i] == '\r' && header_buf[i + 1] == '\n' &&
-                    header_buf[i + 2] == '\r' && header_buf[i + 3] == '\n') {
-                    header_end = header_buf + i + 4;
-                    size_t header_len = i + 4;
-                    if (header_len < sizeof(header_buf)) {
-                        header_buf[header_len] = '\0';
-                    } else {
-                        header_buf[sizeof(header_buf) - 1] = '\0';
-                    }
-                    char *line_end = strstr(header_buf, "\r\n");
-                    if (line_end) {
-                        *line_end = '\0';
-                        (void)sscanf(header_buf, "HTTP/%*s %d", &status);
-                    }
-                    header_done = 1;
-                    size_t body_part = header_used - header_len;
-                    if (body_part > 0) {
-                        char *new_out = realloc(out, out_len + body_part + 1);
-                        if (!new_out) break;
-                        out = new_out;
-                        memcpy(out + out_len, header_end, body_part);
-                        out_len += body_part;
-                        out[out_len] = '\0';
-                    }
-                    break;
-                }
-            }
-        } else {
-            char *new_out = realloc(out, out_len + (size_t)n + 1);
-            if (!new_out) break;
-            out = new_out;
-            memcpy(out + out_len, buf, (size_t)n);
-            out_len += (size_t)n;
-            out[out_len] = '\0';
-        }
-    }
-
-    close(fd);
-    if (out_status) *out_status = status;
-    if (!out) {
-        out = calloc(1, 1);
-    }
-    mesh_log_verbose(config, "mesh: http response %s:%u status=%d body=%zu bytes",
-                     host, port, status, out_len);
-    return out;
-}
-
 static int mesh_mount_points_contains(const junknas_config_t *config, const char *mount_point) {
     if (!config || !mount_point) return 0;
     for (int i = 0; i < config->data_mount_point_count; i++) {
@@ -414,6 +353,7 @@ static void mesh_ensure_local_mount(struct junknas_mesh *mesh) {
         mesh_log_verbose(mesh->config, "mesh: added local mount point %s", mesh->config->mount_point);
     }
     junknas_config_unlock(mesh->config);
+    junknas_config_publish(mesh->config);
 }
 
 static void mesh_mark_active(struct junknas_mesh *mesh) {
@@ -578,25 +518,26 @@ static int mesh_update_from_json(struct junknas_mesh *mesh, const char *payload)
     }
 
     junknas_config_unlock(config);
+    if (changed) junknas_config_publish(config);
     cJSON_Delete(root);
     return changed;
 }
 
-static char *mesh_build_sync_payload(junknas_config_t *config) {
+static char *mesh_build_sync_payload(const junknas_config_snapshot_t *snap) {
     cJSON *root = cJSON_CreateObject();
     if (!root) return NULL;
 
-    if (strcmp(config->node_state, NODE_STATE_NODE) == 0) {
-        cJSON_AddNumberToObject(root, "updated_at", (double)config->wg_peers_updated_at);
-        cJSON_AddNumberToObject(root, "mounts_updated_at", (double)config->data_mount_points_updated_at);
+    if (strcmp(snap->node_state, NODE_STATE_NODE) == 0) {
+        cJSON_AddNumberToObject(root, "updated_at", (double)snap->wg_peers_updated_at);
+        cJSON_AddNumberToObject(root, "mounts_updated_at", (double)snap->data_mount_points_updated_at);
 
         cJSON *self = cJSON_CreateObject();
         if (!self) {
             cJSON_Delete(root);
             return NULL;
         }
-        cJSON_AddStringToObject(self, "endpoint", config->wg.endpoint);
-        cJSON_AddNumberToObject(self, "web_port", (double)config->web_port);
+        cJSON_AddStringToObject(self, "endpoint", snap->wg.endpoint);
+        cJSON_AddNumberToObject(self, "web_port", (double)snap->web_port);
         cJSON_AddItemToObject(root, "self", self);
 
         cJSON *peers = cJSON_CreateArray();
@@ -605,8 +546,8 @@ static char *mesh_build_sync_payload(junknas_config_t *config) {
             return NULL;
         }
         cJSON_AddItemToObject(root, "peers", peers);
-        for (int i = 0; i < config->wg_peer_count; i++) {
-            cJSON *entry = mesh_peer_to_json(&config->wg_peers[i]);
+        for (int i = 0; i < snap->wg_peer_count; i++) {
+            cJSON *entry = mesh_peer_to_json(&snap->wg_peers[i]);
             if (entry) cJSON_AddItemToArray(peers, entry);
         }
 
@@ -616,8 +557,8 @@ static char *mesh_build_sync_payload(junknas_config_t *config) {
             return NULL;
         }
         cJSON_AddItemToObject(root, "mount_points", mounts);
-        for (int i = 0; i < config->data_mount_point_count; i++) {
-            cJSON_AddItemToArray(mounts, cJSON_CreateString(config->data_mount_points[i]));
+        for (int i = 0; i < snap->data_mount_point_count; i++) {
+            cJSON_AddItemToArray(mounts, cJSON_CreateString(snap->data_mount_points[i]));
         }
     } else {
         cJSON_AddNumberToObject(root, "updated_at", 0.0);
@@ -629,6 +570,108 @@ static char *mesh_build_sync_payload(junknas_config_t *config) {
     return printed;
 }
 
+/* ------------------------- Peer chunk inventory -------------------------
+ *
+ * Peers serve a bloom filter over their chunk store at
+ * GET /chunks/inventory; a copy is refreshed after every successful
+ * sync, gated on the generation already held so unchanged filters cost
+ * one small 304 round trip. Fetching and replication consult the
+ * copies: "definitely absent" is exact, "present" can be a false
+ * positive, and a missing or stale filter must never make a chunk
+ * unreachable — so absence demotes a peer rather than excluding it.
+ */
+
+/* -1 = no filter known, 0 = definitely absent, 1 = maybe present */
+static int mesh_inv_check(struct junknas_mesh *mesh, const char *host, uint16_t port,
+                          const char *hashhex) {
+    int rc = -1;
+    pthread_mutex_lock(&mesh->stats_lock);
+    for (int i = 0; i < mesh->inv_count; i++) {
+        if (mesh->invs[i].port == port && strcmp(mesh->invs[i].host, host) == 0) {
+            if (mesh->invs[i].bits) {
+                rc = jnk_inv_maybe_has(mesh->invs[i].bits, hashhex);
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&mesh->stats_lock);
+    return rc;
+}
+
+static void mesh_inv_refresh_peer(struct junknas_mesh *mesh, const char *host, uint16_t port) {
+    uint64_t have_gen = 0;
+    pthread_mutex_lock(&mesh->stats_lock);
+    for (int i = 0; i < mesh->inv_count; i++) {
+        if (mesh->invs[i].port == port && strcmp(mesh->invs[i].host, host) == 0) {
+            if (mesh->invs[i].bits) have_gen = mesh->invs[i].generation;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&mesh->stats_lock);
+
+    char request[512];
+    snprintf(request, sizeof(request),
+             "GET /chunks/inventory?gen=%llu HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n",
+             (unsigned long long)have_gen, host);
+
+    FILE *resp = tmpfile();
+    if (!resp) return;
+    int status = 0;
+    int rc = junknas_http_request(mesh->config, host, port, request, NULL, 0, resp, &status);
+    if (rc != 0) {
+        fclose(resp);
+        if (status == 304) {
+            mesh_log_verbose(mesh->config, "mesh: inventory %s:%u unchanged (gen %llu)",
+                             host, port, (unsigned long long)have_gen);
+        }
+        return;
+    }
+
+    rewind(resp);
+    jnk_inv_hdr_t hdr;
+    uint8_t *bits = NULL;
+    if (fread(&hdr, sizeof(hdr), 1, resp) == 1 &&
+        memcmp(hdr.magic, JNK_INV_MAGIC, 4) == 0 &&
+        hdr.version == JNK_INV_VERSION &&
+        hdr.bytes == JNK_INV_BYTES) {
+        bits = malloc(JNK_INV_BYTES);
+        if (bits && fread(bits, 1, JNK_INV_BYTES, resp) != JNK_INV_BYTES) {
+            free(bits);
+            bits = NULL;
+        }
+    }
+    fclose(resp);
+    if (!bits) {
+        mesh_log_verbose(mesh->config, "mesh: bad inventory response from %s:%u", host, port);
+        return;
+    }
+
+    pthread_mutex_lock(&mesh->stats_lock);
+    mesh_peer_inv_t *inv = NULL;
+    for (int i = 0; i < mesh->inv_count; i++) {
+        if (mesh->invs[i].port == port && strcmp(mesh->invs[i].host, host) == 0) {
+            inv = &mesh->invs[i];
+            break;
+        }
+    }
+    if (!inv && mesh->inv_count < MESH_MAX_PEERS) {
+        inv = &mesh->invs[mesh->inv_count++];
+        snprintf(inv->host, sizeof(inv->host), "%s", host);
+        inv->port = port;
+        inv->bits = NULL;
+    }
+    if (inv) {
+        free(inv->bits);
+        inv->bits = bits;
+        inv->generation = hdr.generation;
+        bits = NULL;
+    }
+    pthread_mutex_unlock(&mesh->stats_lock);
+    free(bits);
+    mesh_log_verbose(mesh->config, "mesh: inventory %s:%u updated (gen %llu)",
+                     host, port, (unsigned long long)hdr.generation);
+}
+
 static int mesh_sync_with_peer(struct junknas_mesh *mesh, const char *endpoint) {
     char host[MAX_ENDPOINT_LEN];
     uint16_t port = 0;
@@ -639,9 +682,10 @@ static int mesh_sync_with_peer(struct junknas_mesh *mesh, const char *endpoint)
 
     mesh_log_verbose(mesh->config, "mesh: syncing with peer %s:%u", host, port);
 
-    junknas_config_lock(mesh->config);
-    char *payload = mesh_build_sync_payload(mesh->config);
-    junknas_config_unlock(mesh->config);
+    junknas_config_snapshot_t *snap = junknas_config_snapshot_get(mesh->config);
+    if (!snap) return -1;
+    char *payload = mesh_build_sync_payload(snap);
+    junknas_config_snapshot_put(snap);
     if (!payload) {
         mesh_log_verbose(mesh->config, "mesh: failed to build sync payload for %s:%u", host, port);
         return -1;
@@ -651,11 +695,11 @@ static int mesh_sync_with_peer(struct junknas_mesh *mesh, const char *endpoint)
     size_t payload_len = strlen(payload);
     mesh_log_verbose(mesh->config, "mesh: sync payload %s:%u (%zu bytes)", host, port, payload_len);
     snprintf(request, sizeof(request),
-             "POST /mesh/peers HTTP/1.1\r\nHost: %s\r\nConnection: close\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n\r\n",
+             "POST /mesh/peers HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n\r\n",
              host, payload_len);
 
     int status = 0;
-    char *body = http_request_body(mesh->config, host, port, request, payload, payload_len, &status);
+    char *body = junknas_http_request_body(mesh->config, host, port, request, payload, payload_len, &status);
     free(payload);
     if (!body) {
         mesh_log_verbose(mesh->config, "mesh: sync failed (no response) from %s:%u", host, port);
@@ -675,19 +719,141 @@ static int mesh_sync_with_peer(struct junknas_mesh *mesh, const char *endpoint)
     free(body);
 
     if (changed > 0) {
-        junknas_config_lock(mesh->config);
-        (void)junknas_config_save(mesh->config, mesh->config->config_file_path);
-        mesh->last_applied_peers_updated_at = mesh->config->wg_peers_updated_at;
-        junknas_config_unlock(mesh->config);
+        /* The listener tick notices wg_peers_updated_at moving and
+         * reconciles the kernel device (mesh_apply_wireguard). */
+        junknas_config_mark_dirty(mesh->config);
         mesh_mark_active(mesh);
     }
 
+    if (ok) {
+        mesh_inv_refresh_peer(mesh, host, port);
+    }
+
     return ok ? 0 : -1;
 }
 
-static __attribute__((unused)) int mesh_apply_wireguard(struct junknas_mesh *mesh) {
-    (void)mesh;
-    return 0;
+/* Parse "host:port" into a WireGuard endpoint sockaddr. Hostnames are
+ * resolved; peers without a public endpoint (LAN-only, wg_ip reachable)
+ * simply get no endpoint attribute and wait for the other side. */
+static int mesh_wg_endpoint(const char *endpoint, wg_endpoint *out) {
+    char host[MAX_ENDPOINT_LEN];
+    uint16_t port = 0;
+    if (parse_endpoint(endpoint, host, sizeof(host), &port) != 0) return -1;
+
+    char portstr[8];
+    snprintf(portstr, sizeof(portstr), "%u", port);
+    struct addrinfo hints = {0};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(host, portstr, &hints, &res) != 0 || !res) return -1;
+
+    int rc = -1;
+    if (res->ai_family == AF_INET && res->ai_addrlen == sizeof(out->addr4)) {
+        memcpy(&out->addr4, res->ai_addr, sizeof(out->addr4));
+        rc = 0;
+    } else if (res->ai_family == AF_INET6 && res->ai_addrlen == sizeof(out->addr6)) {
+        memcpy(&out->addr6, res->ai_addr, sizeof(out->addr6));
+        rc = 0;
+    }
+    freeaddrinfo(res);
+    return rc;
+}
+
+/* Converge the kernel WireGuard device on the configured peer set.
+ * wg_sync_device() diffs against current kernel state and sends only the
+ * added/changed/removed peers in one netlink message, so established
+ * tunnels keep their handshakes across mesh syncs. Nodes without keys
+ * (or without the privileges to program the device) carry on over plain
+ * TCP as before. */
+static int mesh_apply_wireguard(struct junknas_mesh *mesh) {
+    junknas_config_snapshot_t *snap = junknas_config_snapshot_get(mesh->config);
+    if (!snap) return -1;
+    if (snap->wg.interface_name[0] == '\0' || snap->wg.private_key[0] == '\0') {
+        junknas_config_snapshot_put(snap);
+        return 0;
+    }
+
+    junknas_config_lock(mesh->config);
+    uint16_t default_keepalive = mesh->config->wg_peer_keepalive;
+    junknas_config_unlock(mesh->config);
+
+    wg_device dev = {0};
+    snprintf(dev.name, sizeof(dev.name), "%.*s",
+             (int)sizeof(dev.name) - 1, snap->wg.interface_name);
+    if (wg_key_from_base64(dev.private_key, snap->wg.private_key) != 0) {
+        mesh_log_verbose(mesh->config, "mesh: bad wg private key, not applying");
+        junknas_config_snapshot_put(snap);
+        return -1;
+    }
+    dev.flags |= WGDEVICE_HAS_PRIVATE_KEY;
+    if (snap->wg.listen_port) {
+        dev.listen_port = snap->wg.listen_port;
+        dev.flags |= WGDEVICE_HAS_LISTEN_PORT;
+    }
+
+    int count = snap->wg_peer_count;
+    if (count > MESH_MAX_PEERS) count = MESH_MAX_PEERS;
+    wg_peer *peers = calloc(count ? count : 1, sizeof(wg_peer));
+    wg_allowedip *ips = calloc(count ? count : 1, sizeof(wg_allowedip));
+    if (!peers || !ips) {
+        free(peers);
+        free(ips);
+        junknas_config_snapshot_put(snap);
+        return -1;
+    }
+
+    int used = 0;
+    for (int i = 0; i < count; i++) {
+        const junknas_wg_peer_t *src = &snap->wg_peers[i];
+        wg_peer *p = &peers[used];
+        if (src->public_key[0] == '\0' ||
+            wg_key_from_base64(p->public_key, src->public_key) != 0) {
+            continue;
+        }
+        p->flags = WGPEER_HAS_PUBLIC_KEY;
+        if (src->preshared_key[0] != '\0' &&
+            wg_key_from_base64(p->preshared_key, src->preshared_key) == 0) {
+            p->flags |= WGPEER_HAS_PRESHARED_KEY;
+        }
+        uint16_t keepalive = src->persistent_keepalive ? src->persistent_keepalive
+                                                       : default_keepalive;
+        if (keepalive) {
+            p->persistent_keepalive_interval = keepalive;
+            p->flags |= WGPEER_HAS_PERSISTENT_KEEPALIVE_INTERVAL;
+        }
+        if (src->endpoint[0] != '\0') {
+            (void)mesh_wg_endpoint(src->endpoint, &p->endpoint);
+        }
+        if (src->wg_ip[0] != '\0' && inet_pton(AF_INET, src->wg_ip, &ips[used].ip4) == 1) {
+            ips[used].family = AF_INET;
+            ips[used].cidr = 32;
+            p->first_allowedip = p->last_allowedip = &ips[used];
+        }
+        if (used > 0) peers[used - 1].next_peer = p;
+        used++;
+    }
+    if (used > 0) {
+        dev.first_peer = &peers[0];
+        dev.last_peer = &peers[used - 1];
+    }
+    junknas_config_snapshot_put(snap);
+
+    int rc = wg_sync_device(&dev);
+    if (rc == -ENODEV) {
+        /* First run on this boot: create the interface, then a plain
+         * full set (there is nothing to disturb yet). */
+        rc = wg_add_device(dev.name);
+        if (rc == 0) {
+            dev.flags |= WGDEVICE_REPLACE_PEERS;
+            rc = wg_set_device(&dev);
+        }
+    }
+    mesh_log_verbose(mesh->config, "mesh: wireguard apply %s (%d peers, rc=%d)",
+                     rc == 0 ? "ok" : "failed", used, rc);
+    free(peers);
+    free(ips);
+    return rc == 0 ? 0 : -1;
 }
 
 static __attribute__((unused)) int mesh_ensure_wg_keys(struct junknas_mesh *mesh) {
@@ -697,9 +863,9 @@ static __attribute__((unused)) int mesh_ensure_wg_keys(struct junknas_mesh *mesh
 
 static void mesh_refresh_active(struct junknas_mesh *mesh) {
     if (!mesh || !mesh->config) return;
-    junknas_config_lock(mesh->config);
-    int active = (mesh->config->wg_peer_count > 0);
-    junknas_config_unlock(mesh->config);
+    junknas_config_snapshot_t *snap = junknas_config_snapshot_get(mesh->config);
+    int active = (snap && snap->wg_peer_count > 0);
+    junknas_config_snapshot_put(snap);
     pthread_mutex_lock(&mesh->lock);
     mesh->active = active;
     pthread_mutex_unlock(&mesh->lock);
@@ -712,25 +878,30 @@ static void *mesh_listener_thread(void *arg) {
         int did_sync = 0;
         time_t now = time(NULL);
         mesh_log_verbose(mesh->config, "mesh: sync tick start (ts=%ld)", (long)now);
-        junknas_config_lock(mesh->config);
-        int peer_count = mesh->config->bootstrap_peer_count;
+        junknas_config_snapshot_t *snap = junknas_config_snapshot_get(mesh->config);
+        if (!snap) {
+            sleep(1);
+            continue;
+        }
+        int peer_count = snap->bootstrap_peer_count;
         char peers[MAX_BOOTSTRAP_PEERS][MAX_ENDPOINT_LEN];
         for (int i = 0; i < peer_count; i++) {
-            snprintf(peers[i], sizeof(peers[i]), "%s", mesh->config->bootstrap_peers[i]);
+            snprintf(peers[i], sizeof(peers[i]), "%s", snap->bootstrap_peers[i]);
         }
-        int wg_peer_count = mesh->config->wg_peer_count;
-        uint64_t peers_updated_at = mesh->config->wg_peers_updated_at;
-        uint16_t default_web_port = mesh->config->web_port;
+        int wg_peer_count = snap->wg_peer_count;
+        uint64_t peers_updated_at = snap->wg_peers_updated_at;
+        uint16_t default_web_port = snap->web_port;
         junknas_wg_peer_t wg_peers[MESH_MAX_PEERS];
         if (wg_peer_count > MESH_MAX_PEERS) wg_peer_count = MESH_MAX_PEERS;
         for (int i = 0; i < wg_peer_count; i++) {
-            wg_peers[i] = mesh->config->wg_peers[i];
+            wg_peers[i] = snap->wg_peers[i];
         }
-        junknas_config_unlock(mesh->config);
+        junknas_config_snapshot_put(snap);
         mesh_log_verbose(mesh->config, "mesh: tick peers bootstrap=%d wg=%d", peer_count, wg_peer_count);
 
         if (peers_updated_at != mesh->last_applied_peers_updated_at) {
-            mesh_log_verbose(mesh->config, "mesh: peer config changed");
+            mesh_log_verbose(mesh->config, "mesh: peer config changed, reconciling wireguard");
+            (void)mesh_apply_wireguard(mesh);
             mesh->last_applied_peers_updated_at = peers_updated_at;
         }
 
@@ -761,6 +932,9 @@ static void *mesh_listener_thread(void *arg) {
             if (rc == 0) did_sync = 1;
         }
 
+        /* One republish per tick picks up the status flags above. */
+        junknas_config_publish(mesh->config);
+
         if (!did_sync) {
             mesh_refresh_active(mesh);
         }
@@ -774,179 +948,799 @@ static void *mesh_listener_thread(void *arg) {
     return NULL;
 }
 
-static int http_request(const junknas_config_t *config, const char *host, uint16_t port,
-                        const char *request, const uint8_t *body, size_t body_len,
-                        FILE *out, int *out_status) {
-    struct sockaddr_storage addr;
-    socklen_t addr_len = 0;
-    if (resolve_addr(host, port, SOCK_STREAM, &addr, &addr_len) != 0) {
-        mesh_log_verbose(config, "mesh: http resolve failed for %s:%u", host, port);
-        return -1;
-    }
+/* ------------------------- Hedged chunk fetch ---------------------------
+ *
+ * Fetching a chunk peer-by-peer means a degraded mesh read waits out the
+ * full socket timeout on every dead peer before reaching a live one.
+ * Instead, peers are ranked by a latency EWMA and queried in waves of
+ * MESH_FETCH_HEDGE concurrent GETs; the first complete response wins and
+ * the losers' results are discarded. Every attempt feeds the ranking, so
+ * slow or dead peers drift to later waves on their own.
+ */
 
-    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
-    if (fd < 0) {
-        mesh_log_verbose(config, "mesh: http socket create failed for %s:%u", host, port);
-        return -1;
+static double mesh_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static double mesh_stat_score(struct junknas_mesh *mesh, const char *host, uint16_t port) {
+    double score = MESH_STAT_DEFAULT_MS;
+    pthread_mutex_lock(&mesh->stats_lock);
+    for (int i = 0; i < mesh->stat_count; i++) {
+        if (mesh->stats[i].port == port && strcmp(mesh->stats[i].host, host) == 0) {
+            score = mesh->stats[i].ewma_ms;
+            break;
+        }
     }
+    pthread_mutex_unlock(&mesh->stats_lock);
+    return score;
+}
 
-    if (connect(fd, (struct sockaddr *)&addr, addr_len) != 0) {
-        mesh_log_verbose(config, "mesh: http connect failed for %s:%u", host, port);
-        close(fd);
-        return -1;
+static void mesh_stat_record(struct junknas_mesh *mesh, const char *host, uint16_t port,
+                             double sample_ms) {
+    pthread_mutex_lock(&mesh->stats_lock);
+    mesh_peer_stat_t *st = NULL;
+    for (int i = 0; i < mesh->stat_count; i++) {
+        if (mesh->stats[i].port == port && strcmp(mesh->stats[i].host, host) == 0) {
+            st = &mesh->stats[i];
+            break;
+        }
+    }
+    if (!st && mesh->stat_count < MESH_MAX_PEERS) {
+        st = &mesh->stats[mesh->stat_count++];
+        snprintf(st->host, sizeof(st->host), "%s", host);
+        st->port = port;
+        st->ewma_ms = sample_ms;
+        st->samples = 0;
+    }
+    if (st) {
+        st->ewma_ms = (1.0 - MESH_STAT_ALPHA) * st->ewma_ms + MESH_STAT_ALPHA * sample_ms;
+        st->samples++;
     }
+    pthread_mutex_unlock(&mesh->stats_lock);
+}
 
-    size_t request_len = strlen(request);
-    mesh_log_verbose(config, "mesh: http send request %s:%u (%zu bytes)", host, port, request_len);
-    if (send(fd, request, request_len, 0) < 0) {
-        mesh_log_verbose(config, "mesh: http send request failed for %s:%u", host, port);
-        close(fd);
-        return -1;
+/* Shared state for one hedged fetch. Workers are detached; the last
+ * reference (workers + the waiting caller) frees the context. */
+typedef struct {
+    struct junknas_mesh *mesh;
+    char hashhex[65];
+    char dest_path[MAX_PATH_LEN];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int pending;                       /* workers still running in this wave */
+    int won;
+    int refs;
+} mesh_fetch_ctx_t;
+
+typedef struct {
+    mesh_fetch_ctx_t *ctx;
+    char host[MAX_ENDPOINT_LEN];
+    uint16_t port;
+    int idx;
+} mesh_fetch_task_t;
+
+static void mesh_fetch_ctx_unref(mesh_fetch_ctx_t *ctx) {
+    pthread_mutex_lock(&ctx->lock);
+    int refs = --ctx->refs;
+    pthread_mutex_unlock(&ctx->lock);
+    if (refs == 0) {
+        pthread_mutex_destroy(&ctx->lock);
+        pthread_cond_destroy(&ctx->cond);
+        free(ctx);
     }
-    if (body && body_len > 0) {
-        mesh_log_verbose(config, "mesh: http send body %s:%u (%zu bytes)", host, port, body_len);
-        if (send(fd, body, body_len, 0) < 0) {
-            mesh_log_verbose(config, "mesh: http send body failed for %s:%u", host, port);
-            close(fd);
-            return -1;
+}
+
+static void *mesh_fetch_worker(void *arg) {
+    mesh_fetch_task_t *task = arg;
+    mesh_fetch_ctx_t *ctx = task->ctx;
+    struct junknas_mesh *mesh = ctx->mesh;
+
+    char tmp_path[MAX_PATH_LEN];
+    int rc = -1;
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.part.%d", ctx->dest_path, task->idx)
+            < (int)sizeof(tmp_path)) {
+        char request[512];
+        snprintf(request, sizeof(request),
+                 "GET /chunks/%s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n",
+                 ctx->hashhex, task->host);
+
+        FILE *out = fopen(tmp_path, "wb");
+        if (out) {
+            double t0 = mesh_now_ms();
+            int status = 0;
+            rc = junknas_http_request(mesh->config, task->host, task->port,
+                                      request, NULL, 0, out, &status);
+            fclose(out);
+            mesh_stat_record(mesh, task->host, task->port,
+                             rc == 0 ? mesh_now_ms() - t0 : MESH_STAT_FAIL_MS);
         }
     }
 
-    char buf[4096];
-    char header_buf[8192 + 1];
-    size_t header_used = 0;
-    int status = 0;
-    int header_done = 0;
-    while (1) {
-        ssize_t n = recv(fd, buf, sizeof(buf), 0);
-        if (n <= 0) break;
-        mesh_log_verbose(config, "mesh: http recv chunk %s:%u (%zd bytes)", host, port, n);
-
-        if (!header_done) {
-            size_t to_copy = (size_t)n;
-            if (header_used + to_copy > sizeof(header_buf)) {
-                to_copy = sizeof(header_buf) - header_used;
-            }
-            memcpy(header_buf + header_used, buf, to_copy);
-            header_used += to_copy;
-
-            char *header_end = NULL;
-            for (size_t i = 0; i + 3 < header_used; i++) {
-                if (header_buf[i] == '\r' && header_buf[i + 1] == '\n' &&
-                    header_buf[i + 2] == '\r' && header_buf[i + 3] == '\n') {
-                    header_end = header_buf + i + 4;
-                    size_t header_len = i + 4;
-                    if (header_len < sizeof(header_buf)) {
-                        header_buf[header_len] = '\0';
-                    } else {
-                        header_buf[sizeof(header_buf) - 1] = '\0';
-                    }
-                    char *line_end = strstr(header_buf, "\r\n");
-                    if (line_end) {
-                        *line_end = '\0';
-                        (void)sscanf(header_buf, "HTTP/%*s %d", &status);
-                    }
-                    header_done = 1;
-                    size_t body_part = header_used - header_len;
-                    if (body_part > 0 && out) {
-                        fwrite(header_end, 1, body_part, out);
-                    }
-                    break;
-                }
-            }
-        } else if (out) {
-            fwrite(buf, 1, (size_t)n, out);
-        }
+    pthread_mutex_lock(&ctx->lock);
+    if (rc == 0 && !ctx->won && rename(tmp_path, ctx->dest_path) == 0) {
+        ctx->won = 1;
+    } else {
+        (void)unlink(tmp_path);
     }
+    ctx->pending--;
+    pthread_cond_signal(&ctx->cond);
+    pthread_mutex_unlock(&ctx->lock);
+
+    mesh_fetch_ctx_unref(ctx);
+
+    pthread_mutex_lock(&mesh->stats_lock);
+    mesh->fetch_inflight--;
+    pthread_cond_broadcast(&mesh->stats_cond);
+    pthread_mutex_unlock(&mesh->stats_lock);
+
+    free(task);
+    return NULL;
+}
 
-    close(fd);
-    if (out_status) *out_status = status;
-    mesh_log_verbose(config, "mesh: http response %s:%u status=%d", host, port, status);
-    return (status >= 200 && status < 300) ? 0 : -1;
+typedef struct {
+    char host[MAX_ENDPOINT_LEN];
+    uint16_t port;
+    double score;
+} mesh_peer_cand_t;
+
+/* Snapshot the current peer set ordered by fetch score, best first.
+ * When hashhex is given, peers whose inventory says the chunk is
+ * definitely absent are demoted behind the likely holders. */
+static int mesh_rank_peers(struct junknas_mesh *mesh, mesh_peer_cand_t *cand, int max,
+                           const char *hashhex) {
+    junknas_config_snapshot_t *snap = junknas_config_snapshot_get(mesh->config);
+    if (!snap) return 0;
+    int peer_count = snap->wg_peer_count;
+    if (peer_count > MESH_MAX_PEERS) peer_count = MESH_MAX_PEERS;
+    uint16_t default_web_port = snap->web_port;
+
+    int cand_count = 0;
+    for (int i = 0; i < peer_count && cand_count < max; i++) {
+        char host[MAX_ENDPOINT_LEN];
+        uint16_t port = 0;
+        if (mesh_peer_hostport(&snap->wg_peers[i], default_web_port, host, sizeof(host), &port) != 0) {
+            continue;
+        }
+        double score = mesh_stat_score(mesh, host, port);
+        if (hashhex && mesh_inv_check(mesh, host, port, hashhex) == 0) {
+            score += MESH_STAT_FAIL_MS;
+        }
+        int pos = cand_count;
+        while (pos > 0 && cand[pos - 1].score > score) {
+            cand[pos] = cand[pos - 1];
+            pos--;
+        }
+        snprintf(cand[pos].host, sizeof(cand[pos].host), "%s", host);
+        cand[pos].port = port;
+        cand[pos].score = score;
+        cand_count++;
+    }
+    junknas_config_snapshot_put(snap);
+    return cand_count;
 }
 
 int junknas_mesh_fetch_chunk(junknas_mesh_t *mesh, const char *hashhex, const char *dest_path) {
     if (!mesh || !hashhex || !dest_path) return -1;
     if (!junknas_mesh_is_active(mesh)) return -1;
+    if (strlen(hashhex) != 64 || strlen(dest_path) >= MAX_PATH_LEN) return -1;
+    uint64_t m0 = jnk_metric_now_us();
     mesh_log_verbose(mesh->config, "mesh: fetch chunk %s -> %s", hashhex, dest_path);
 
-    junknas_config_lock(mesh->config);
-    junknas_wg_peer_t peers[MESH_MAX_PEERS];
-    int peer_count = mesh->config->wg_peer_count;
-    if (peer_count > MESH_MAX_PEERS) peer_count = MESH_MAX_PEERS;
-    for (int i = 0; i < peer_count; i++) {
-        peers[i] = mesh->config->wg_peers[i];
+    mesh_peer_cand_t cand[MESH_MAX_PEERS];
+    int cand_count = mesh_rank_peers(mesh, cand, MESH_MAX_PEERS, hashhex);
+    if (cand_count == 0) return -1;
+
+    mesh_fetch_ctx_t *ctx = calloc(1, sizeof(*ctx));
+    if (!ctx) return -1;
+    ctx->mesh = mesh;
+    snprintf(ctx->hashhex, sizeof(ctx->hashhex), "%s", hashhex);
+    snprintf(ctx->dest_path, sizeof(ctx->dest_path), "%s", dest_path);
+    pthread_mutex_init(&ctx->lock, NULL);
+    pthread_cond_init(&ctx->cond, NULL);
+    ctx->refs = 1;                     /* the waiting caller */
+
+    for (int wave = 0; wave < cand_count; wave += MESH_FETCH_HEDGE) {
+        int wave_end = wave + MESH_FETCH_HEDGE;
+        if (wave_end > cand_count) wave_end = cand_count;
+
+        for (int i = wave; i < wave_end; i++) {
+            mesh_fetch_task_t *task = calloc(1, sizeof(*task));
+            if (!task) continue;
+            task->ctx = ctx;
+            snprintf(task->host, sizeof(task->host), "%s", cand[i].host);
+            task->port = cand[i].port;
+            task->idx = i;
+
+            pthread_mutex_lock(&ctx->lock);
+            ctx->pending++;
+            ctx->refs++;
+            pthread_mutex_unlock(&ctx->lock);
+            pthread_mutex_lock(&mesh->stats_lock);
+            mesh->fetch_inflight++;
+            pthread_mutex_unlock(&mesh->stats_lock);
+
+            mesh_log_verbose(mesh->config, "mesh: fetching chunk %s from %s:%u (score=%.0fms)",
+                             hashhex, task->host, task->port, cand[i].score);
+            pthread_t tid;
+            if (pthread_create(&tid, NULL, mesh_fetch_worker, task) != 0) {
+                pthread_mutex_lock(&ctx->lock);
+                ctx->pending--;
+                ctx->refs--;
+                pthread_mutex_unlock(&ctx->lock);
+                pthread_mutex_lock(&mesh->stats_lock);
+                mesh->fetch_inflight--;
+                pthread_mutex_unlock(&mesh->stats_lock);
+                free(task);
+                continue;
+            }
+            pthread_detach(tid);
+        }
+
+        pthread_mutex_lock(&ctx->lock);
+        while (!ctx->won && ctx->pending > 0) {
+            pthread_cond_wait(&ctx->cond, &ctx->lock);
+        }
+        int won = ctx->won;
+        pthread_mutex_unlock(&ctx->lock);
+        if (won) break;
     }
-    uint16_t default_web_port = mesh->config->web_port;
-    junknas_config_unlock(mesh->config);
 
-    for (int i = 0; i < peer_count; i++) {
-        char host[MAX_ENDPOINT_LEN];
-        uint16_t port = 0;
-        if (mesh_peer_hostport(&peers[i], default_web_port, host, sizeof(host), &port) != 0) {
+    pthread_mutex_lock(&ctx->lock);
+    int won = ctx->won;
+    pthread_mutex_unlock(&ctx->lock);
+    mesh_fetch_ctx_unref(ctx);
+
+    jnk_metric_observe_us(JNK_HIST_MESH_FETCH, jnk_metric_now_us() - m0);
+    if (won) {
+        jnk_metric_add(JNK_CTR_MESH_FETCH_OK, 1);
+        mesh_log_verbose(mesh->config, "mesh: fetch chunk %s succeeded", hashhex);
+        return 0;
+    }
+    jnk_metric_add(JNK_CTR_MESH_FETCH_FAIL, 1);
+    mesh_log_verbose(mesh->config, "mesh: fetch chunk %s failed on all peers", hashhex);
+    return -1;
+}
+
+/* Copy len bytes from the batch response stream into dest_path via a
+ * temp file, so a short or torn entry never leaves a partial chunk. */
+static int mesh_batch_take_payload(FILE *resp, const char *dest_path, long long len) {
+    char tmp_path[MAX_PATH_LEN];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.part", dest_path) >= (int)sizeof(tmp_path)) {
+        return -1;
+    }
+    FILE *out = fopen(tmp_path, "wb");
+    if (!out) return -1;
+
+    char buf[4096];
+    long long remaining = len;
+    while (remaining > 0) {
+        size_t ask = remaining > (long long)sizeof(buf) ? sizeof(buf) : (size_t)remaining;
+        size_t n = fread(buf, 1, ask, resp);
+        if (n == 0) break;
+        if (fwrite(buf, 1, n, out) != n) break;
+        remaining -= (long long)n;
+    }
+    fclose(out);
+
+    if (remaining != 0 || rename(tmp_path, dest_path) != 0) {
+        (void)unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+int junknas_mesh_fetch_chunks(junknas_mesh_t *mesh, int count,
+                              char (*hashes)[65],
+                              char (*dest_paths)[MAX_PATH_LEN]) {
+    if (!mesh || !hashes || !dest_paths || count <= 0) return -1;
+    if (!junknas_mesh_is_active(mesh)) return -1;
+    if (count > MESH_FETCH_BATCH_MAX) count = MESH_FETCH_BATCH_MAX;
+
+    mesh_peer_cand_t cand[MESH_MAX_PEERS];
+    int cand_count = mesh_rank_peers(mesh, cand, MESH_MAX_PEERS, NULL);
+    if (cand_count == 0) return -1;
+
+    char *done = calloc((size_t)count, 1);
+    if (!done) return -1;
+    uint64_t m0 = jnk_metric_now_us();
+    int fetched = 0;
+
+    for (int c = 0; c < cand_count && fetched < count; c++) {
+        /* List the hashes this peer still needs to serve, leaving out
+         * any its inventory says it cannot have. A chunk every known
+         * filter rejects still reaches peers with no filter here, and
+         * the caller's single-chunk fallback never excludes anyone. */
+        char *list = malloc((size_t)count * 66 + 1);
+        if (!list) break;
+        size_t list_len = 0;
+        int asked = 0;
+        for (int i = 0; i < count; i++) {
+            if (done[i]) continue;
+            if (mesh_inv_check(mesh, cand[c].host, cand[c].port, hashes[i]) == 0) continue;
+            memcpy(list + list_len, hashes[i], 64);
+            list[list_len + 64] = '\n';
+            list_len += 65;
+            asked++;
+        }
+        list[list_len] = '\0';
+        if (asked == 0) {
+            free(list);
             continue;
         }
+
         char request[512];
         snprintf(request, sizeof(request),
-                 "GET /chunks/%s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n",
-                 hashhex, host);
+                 "POST /chunks/batch HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\nContent-Length: %zu\r\n\r\n",
+                 cand[c].host, list_len);
 
-        FILE *out = fopen(dest_path, "wb");
-        if (!out) continue;
+        FILE *resp = tmpfile();
+        if (!resp) { free(list); break; }
+
+        mesh_log_verbose(mesh->config, "mesh: batch fetching %d chunks from %s:%u",
+                         asked, cand[c].host, cand[c].port);
+        double t0 = mesh_now_ms();
         int status = 0;
-        mesh_log_verbose(mesh->config, "mesh: fetching chunk %s from %s:%u",
-                         hashhex, host, port);
-        int rc = http_request(mesh->config, host, port,
-                              request, NULL, 0, out, &status);
-        fclose(out);
+        int rc = junknas_http_request(mesh->config, cand[c].host, cand[c].port,
+                                      request, list, list_len, resp, &status);
+        free(list);
+        if (rc != 0) {
+            fclose(resp);
+            mesh_stat_record(mesh, cand[c].host, cand[c].port, MESH_STAT_FAIL_MS);
+            continue;
+        }
 
-        if (rc == 0) {
-            mesh_log_verbose(mesh->config, "mesh: fetch chunk %s succeeded via %s:%u",
-                             hashhex, host, port);
-            return 0;
+        rewind(resp);
+        int got = 0;
+        char hh[65];
+        long long len = 0;
+        while (fscanf(resp, "%64s %lld", hh, &len) == 2) {
+            (void)fgetc(resp);         /* consume the newline */
+            int idx = -1;
+            for (int i = 0; i < count; i++) {
+                if (!done[i] && strcmp(hashes[i], hh) == 0) { idx = i; break; }
+            }
+            if (len < 0) continue;
+            if (idx < 0) {
+                if (fseek(resp, len, SEEK_CUR) != 0) break;
+                continue;
+            }
+            if (mesh_batch_take_payload(resp, dest_paths[idx], len) != 0) break;
+            done[idx] = 1;
+            fetched++;
+            got++;
         }
-        (void)unlink(dest_path);
+        fclose(resp);
+
+        /* Record the per-chunk cost so batch samples rank against the
+         * single-fetch EWMA on equal footing. */
+        mesh_stat_record(mesh, cand[c].host, cand[c].port,
+                         got > 0 ? (mesh_now_ms() - t0) / got : MESH_STAT_FAIL_MS);
     }
 
-    mesh_log_verbose(mesh->config, "mesh: fetch chunk %s failed on all peers", hashhex);
-    return -1;
+    free(done);
+    jnk_metric_observe_us(JNK_HIST_MESH_FETCH, jnk_metric_now_us() - m0);
+    jnk_metric_add(JNK_CTR_MESH_FETCH_OK, (uint64_t)fetched);
+    jnk_metric_add(JNK_CTR_MESH_FETCH_FAIL, (uint64_t)(count - fetched));
+    mesh_log_verbose(mesh->config, "mesh: batch fetch got %d of %d chunks", fetched, count);
+    return fetched;
 }
 
-int junknas_mesh_replicate_chunk(junknas_mesh_t *mesh,
-                                const char *hashhex,
-                                const uint8_t *data,
-                                size_t len) {
-    if (!mesh || !hashhex || !data || len == 0) return -1;
-    if (!junknas_mesh_is_active(mesh)) return -1;
-    mesh_log_verbose(mesh->config, "mesh: replicate chunk %s (%zu bytes)", hashhex, len);
+/* ------------------------- Chunk replication ----------------------------
+ *
+ * The FUSE commit path only enqueues: sender threads drain a bounded
+ * in-memory queue in the background, so local write latency never waits
+ * on peer RTTs or dead peers. Failed sends come back as per-peer retry
+ * items with exponential backoff; overflow and shutdown leftovers go to
+ * a spill journal that is re-read when the queue drains, so pending
+ * replication also survives a restart.
+ */
+
+static int mesh_send_chunk_to(struct junknas_mesh *mesh, const char *host, uint16_t port,
+                              const char *hashhex, const uint8_t *data, size_t len) {
+    char request[512];
+    snprintf(request, sizeof(request),
+             "POST /chunks/%s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\nContent-Length: %zu\r\n\r\n",
+             hashhex, host, len);
+    mesh_log_verbose(mesh->config, "mesh: replicating chunk %s -> %s:%u",
+                     hashhex, host, port);
+    int rc = junknas_http_request(mesh->config, host, port, request, data, len, NULL, NULL);
+    if (rc == 0) jnk_metric_add(JNK_CTR_MESH_CHUNKS_SENT, 1);
+    return rc;
+}
+
+/* Caller holds repl.lock */
+static void mesh_repl_push_locked(mesh_repl_t *q, mesh_repl_item_t *it) {
+    it->next = NULL;
+    if (q->tail) q->tail->next = it;
+    else q->head = it;
+    q->tail = it;
+    q->count++;
+}
+
+/* Append one item as a spill line. Caller holds repl.lock. */
+static void mesh_repl_spill_one(mesh_repl_t *q, const mesh_repl_item_t *it) {
+    FILE *f = fopen(q->spill_path, "a");
+    if (!f) return;
+    fprintf(f, "%s %s %s %d\n", it->hashhex, it->path,
+            it->endpoint[0] ? it->endpoint : "*", it->attempts);
+    fclose(f);
+    q->spill_nonempty = 1;
+}
+
+/* Pull spilled lines back into the queue (up to the cap), rewriting the
+ * remainder. Caller holds repl.lock. */
+static void mesh_repl_refill_locked(mesh_repl_t *q) {
+    if (!q->spill_nonempty) return;
+
+    FILE *f = fopen(q->spill_path, "r");
+    if (!f) { q->spill_nonempty = 0; return; }
+
+    char tmp[MAX_PATH_LEN];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", q->spill_path) >= (int)sizeof(tmp)) {
+        fclose(f);
+        return;
+    }
+    FILE *rest = fopen(tmp, "w");
+
+    char line[MAX_PATH_LEN + 256];
+    int leftover = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (q->count < MESH_REPL_QUEUE_MAX) {
+            mesh_repl_item_t *it = calloc(1, sizeof(*it));
+            if (!it) continue;
+            char ep[MAX_ENDPOINT_LEN];
+            if (sscanf(line, "%64s %4095s %255s %d",
+                       it->hashhex, it->path, ep, &it->attempts) == 4) {
+                if (strcmp(ep, "*") != 0) {
+                    strncpy(it->endpoint, ep, sizeof(it->endpoint) - 1);
+                }
+                mesh_repl_push_locked(q, it);
+            } else {
+                free(it);
+            }
+        } else if (rest) {
+            fputs(line, rest);
+            leftover = 1;
+        }
+    }
+    fclose(f);
+    if (rest) fclose(rest);
+
+    if (leftover) {
+        (void)rename(tmp, q->spill_path);
+    } else {
+        (void)unlink(tmp);
+        (void)unlink(q->spill_path);
+        q->spill_nonempty = 0;
+    }
+}
+
+static void mesh_repl_enqueue(struct junknas_mesh *mesh, const char *hashhex,
+                              const char *path, const char *endpoint, int attempts, time_t due) {
+    mesh_repl_t *q = &mesh->repl;
+    mesh_repl_item_t *it = calloc(1, sizeof(*it));
+    if (!it) return;
+
+    strncpy(it->hashhex, hashhex, sizeof(it->hashhex) - 1);
+    strncpy(it->path, path, sizeof(it->path) - 1);
+    if (endpoint) strncpy(it->endpoint, endpoint, sizeof(it->endpoint) - 1);
+    it->attempts = attempts;
+    it->due = due;
+
+    pthread_mutex_lock(&q->lock);
+    if (q->count >= MESH_REPL_QUEUE_MAX) {
+        mesh_repl_spill_one(q, it);
+        free(it);
+    } else {
+        mesh_repl_push_locked(q, it);
+        pthread_cond_signal(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+}
+
+/* Schedule a backed-off per-peer retry for a failed send, or drop the
+ * item after MESH_REPL_RETRY_MAX attempts. */
+static void mesh_repl_retry(struct junknas_mesh *mesh, const mesh_repl_item_t *it,
+                            const char *host, uint16_t port) {
+    int attempts = it->attempts + 1;
+    if (attempts >= MESH_REPL_RETRY_MAX) {
+        mesh_log_verbose(mesh->config, "mesh: giving up replicating %s to %s:%u",
+                         it->hashhex, host, port);
+        return;
+    }
+
+    long delay = 1L << attempts;
+    if (delay > MESH_REPL_BACKOFF_CAP) delay = MESH_REPL_BACKOFF_CAP;
+
+    char endpoint[MAX_ENDPOINT_LEN + 16];
+    if (snprintf(endpoint, sizeof(endpoint), "%s:%u", host, (unsigned)port) >= MAX_ENDPOINT_LEN) return;
+    mesh_repl_enqueue(mesh, it->hashhex, it->path, endpoint, attempts, time(NULL) + delay);
+}
+
+/* Send one item to one endpoint; on failure schedule a retry. */
+static void mesh_repl_deliver_one(struct junknas_mesh *mesh, const mesh_repl_item_t *it,
+                                  const char *host, uint16_t port,
+                                  const uint8_t *data, size_t len) {
+    if (mesh_send_chunk_to(mesh, host, port, it->hashhex, data, len) == 0) return;
+    mesh_repl_retry(mesh, it, host, port);
+}
+
+/* Push several chunks to one peer in a single batch-upload request:
+ * each entry is a "<hash> <length>\n" line followed by the payload. */
+static int mesh_send_chunk_batch_to(struct junknas_mesh *mesh, const char *host, uint16_t port,
+                                    mesh_repl_item_t *const *items,
+                                    uint8_t *const *payloads, const size_t *lens,
+                                    const int *idxs, int k) {
+    size_t total = 0;
+    for (int i = 0; i < k; i++) {
+        char entry[128];
+        total += (size_t)snprintf(entry, sizeof(entry), "%s %zu\n",
+                                  items[idxs[i]]->hashhex, lens[idxs[i]]);
+        total += lens[idxs[i]];
+    }
+
+    uint8_t *body = malloc(total);
+    if (!body) return -1;
+    size_t off = 0;
+    for (int i = 0; i < k; i++) {
+        char entry[128];
+        int n = snprintf(entry, sizeof(entry), "%s %zu\n",
+                         items[idxs[i]]->hashhex, lens[idxs[i]]);
+        memcpy(body + off, entry, (size_t)n);
+        off += (size_t)n;
+        memcpy(body + off, payloads[idxs[i]], lens[idxs[i]]);
+        off += lens[idxs[i]];
+    }
+
+    char request[512];
+    snprintf(request, sizeof(request),
+             "POST /chunks/batch-upload HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\nContent-Length: %zu\r\n\r\n",
+             host, total);
+    mesh_log_verbose(mesh->config, "mesh: replicating %d-chunk batch -> %s:%u", k, host, port);
+    int rc = junknas_http_request(mesh->config, host, port, request, body, total, NULL, NULL);
+    free(body);
+    if (rc == 0) jnk_metric_add(JNK_CTR_MESH_CHUNKS_SENT, (uint64_t)k);
+    return rc;
+}
+
+/* Deliver a drained batch of items. Items bound for the same peer ride
+ * one batch-upload request; a destination with a single item keeps the
+ * plain per-chunk POST. */
+static void mesh_repl_process_batch(struct junknas_mesh *mesh, mesh_repl_item_t **items, int n) {
+    uint8_t *payloads[MESH_REPL_BATCH] = {0};
+    size_t lens[MESH_REPL_BATCH] = {0};
+
+    /* Read the chunks from the store now; any that were garbage
+     * collected in the meantime have nothing left to replicate. */
+    for (int i = 0; i < n; i++) {
+        FILE *f = fopen(items[i]->path, "rb");
+        struct stat st;
+        if (!f) {
+            free(items[i]);
+            items[i] = NULL;
+            continue;
+        }
+        if (fstat(fileno(f), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+            fclose(f);
+            free(items[i]);
+            items[i] = NULL;
+            continue;
+        }
+        lens[i] = (size_t)st.st_size;
+        payloads[i] = malloc(lens[i]);
+        if (!payloads[i] || fread(payloads[i], 1, lens[i], f) != lens[i]) {
+            free(payloads[i]);
+            payloads[i] = NULL;
+            free(items[i]);
+            items[i] = NULL;
+        }
+        fclose(f);
+    }
 
-    junknas_config_lock(mesh->config);
     junknas_wg_peer_t peers[MESH_MAX_PEERS];
-    int peer_count = mesh->config->wg_peer_count;
-    if (peer_count > MESH_MAX_PEERS) peer_count = MESH_MAX_PEERS;
-    for (int i = 0; i < peer_count; i++) {
-        peers[i] = mesh->config->wg_peers[i];
+    int peer_count = 0;
+    uint16_t default_web_port = 0;
+    junknas_config_snapshot_t *snap = junknas_config_snapshot_get(mesh->config);
+    if (snap) {
+        peer_count = snap->wg_peer_count;
+        if (peer_count > MESH_MAX_PEERS) peer_count = MESH_MAX_PEERS;
+        for (int i = 0; i < peer_count; i++) peers[i] = snap->wg_peers[i];
+        default_web_port = snap->web_port;
+        junknas_config_snapshot_put(snap);
     }
-    uint16_t default_web_port = mesh->config->web_port;
-    junknas_config_unlock(mesh->config);
 
-    for (int i = 0; i < peer_count; i++) {
+    /* Group items by destination */
+    struct {
         char host[MAX_ENDPOINT_LEN];
-        uint16_t port = 0;
-        if (mesh_peer_hostport(&peers[i], default_web_port, host, sizeof(host), &port) != 0) {
+        uint16_t port;
+        int idxs[MESH_REPL_BATCH];
+        int k;
+    } targets[MESH_REPL_BATCH + MESH_MAX_PEERS];
+    int target_count = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (!items[i]) continue;
+
+        char hosts[MESH_MAX_PEERS][MAX_ENDPOINT_LEN];
+        uint16_t ports[MESH_MAX_PEERS];
+        int dest_count = 0;
+        if (items[i]->endpoint[0]) {
+            if (parse_endpoint(items[i]->endpoint, hosts[0], sizeof(hosts[0]), &ports[0]) == 0) {
+                dest_count = 1;
+            }
+        } else {
+            for (int p = 0; p < peer_count; p++) {
+                if (mesh_peer_hostport(&peers[p], default_web_port,
+                                       hosts[dest_count], sizeof(hosts[dest_count]),
+                                       &ports[dest_count]) != 0) {
+                    continue;
+                }
+                /* Skip peers whose inventory already advertises the
+                 * chunk; a rare bloom false positive just leaves that
+                 * peer's copy to re-replication later. */
+                if (mesh_inv_check(mesh, hosts[dest_count], ports[dest_count],
+                                   items[i]->hashhex) == 1) {
+                    mesh_log_verbose(mesh->config, "mesh: repl skip %s:%u (already has %s)",
+                                     hosts[dest_count], ports[dest_count], items[i]->hashhex);
+                    continue;
+                }
+                dest_count++;
+            }
+        }
+
+        for (int d = 0; d < dest_count; d++) {
+            int t = 0;
+            while (t < target_count &&
+                   (targets[t].port != ports[d] || strcmp(targets[t].host, hosts[d]) != 0)) {
+                t++;
+            }
+            if (t == target_count) {
+                if (target_count >= (int)(sizeof(targets) / sizeof(targets[0]))) continue;
+                snprintf(targets[t].host, sizeof(targets[t].host), "%s", hosts[d]);
+                targets[t].port = ports[d];
+                targets[t].k = 0;
+                target_count++;
+            }
+            if (targets[t].k < MESH_REPL_BATCH) targets[t].idxs[targets[t].k++] = i;
+        }
+    }
+
+    for (int t = 0; t < target_count; t++) {
+        if (targets[t].k == 1) {
+            int i = targets[t].idxs[0];
+            mesh_repl_deliver_one(mesh, items[i], targets[t].host, targets[t].port,
+                                  payloads[i], lens[i]);
+        } else if (mesh_send_chunk_batch_to(mesh, targets[t].host, targets[t].port,
+                                            items, payloads, lens,
+                                            targets[t].idxs, targets[t].k) != 0) {
+            for (int j = 0; j < targets[t].k; j++) {
+                mesh_repl_retry(mesh, items[targets[t].idxs[j]], targets[t].host, targets[t].port);
+            }
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        free(payloads[i]);
+        free(items[i]);
+    }
+}
+
+static void *mesh_repl_sender_thread(void *arg) {
+    struct junknas_mesh *mesh = arg;
+    mesh_repl_t *q = &mesh->repl;
+
+    pthread_mutex_lock(&q->lock);
+    for (;;) {
+        if (!q->head && q->spill_nonempty) mesh_repl_refill_locked(q);
+
+        /* Drain a batch of due items; sleep briefly if everything is
+         * waiting out a backoff window. */
+        time_t now = time(NULL);
+        mesh_repl_item_t *batch[MESH_REPL_BATCH];
+        int batch_count = 0;
+        mesh_repl_item_t **pp = &q->head;
+        while (*pp && batch_count < MESH_REPL_BATCH) {
+            if ((*pp)->due <= now) {
+                mesh_repl_item_t *it = *pp;
+                *pp = it->next;
+                if (q->tail == it) {
+                    mesh_repl_item_t *t = q->head;
+                    while (t && t->next) t = t->next;
+                    q->tail = t;
+                }
+                q->count--;
+                batch[batch_count++] = it;
+                continue;
+            }
+            pp = &(*pp)->next;
+        }
+
+        if (batch_count == 0) {
+            if (q->stop) break;
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += 1;
+            pthread_cond_timedwait(&q->cond, &q->lock, &ts);
             continue;
         }
-        char request[512];
-        snprintf(request, sizeof(request),
-                 "POST /chunks/%s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\nContent-Length: %zu\r\n\r\n",
-                 hashhex, host, len);
-        mesh_log_verbose(mesh->config, "mesh: replicating chunk %s -> %s:%u",
-                         hashhex, host, port);
-        (void)http_request(mesh->config, host, port,
-                           request, data, len, NULL, NULL);
+
+        pthread_mutex_unlock(&q->lock);
+        mesh_repl_process_batch(mesh, batch, batch_count);
+        pthread_mutex_lock(&q->lock);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+static int mesh_repl_start(struct junknas_mesh *mesh) {
+    mesh_repl_t *q = &mesh->repl;
+    memset(q, 0, sizeof(*q));
+
+    if (snprintf(q->spill_path, sizeof(q->spill_path), "%s/.jnk/replication.spill",
+                 mesh->config->data_dir) >= (int)sizeof(q->spill_path)) return -1;
+
+    struct stat st;
+    q->spill_nonempty = (stat(q->spill_path, &st) == 0 && st.st_size > 0);
+
+    if (pthread_mutex_init(&q->lock, NULL) != 0) return -1;
+    pthread_cond_init(&q->cond, NULL);
+
+    for (int i = 0; i < MESH_REPL_SENDERS; i++) {
+        if (pthread_create(&q->senders[i], NULL, mesh_repl_sender_thread, mesh) != 0) {
+            pthread_mutex_lock(&q->lock);
+            q->stop = 1;
+            pthread_cond_broadcast(&q->cond);
+            pthread_mutex_unlock(&q->lock);
+            for (int j = 0; j < i; j++) pthread_join(q->senders[j], NULL);
+            pthread_cond_destroy(&q->cond);
+            pthread_mutex_destroy(&q->lock);
+            return -1;
+        }
+    }
+    q->started = 1;
+    return 0;
+}
+
+static void mesh_repl_stop(struct junknas_mesh *mesh) {
+    mesh_repl_t *q = &mesh->repl;
+    if (!q->started) return;
+
+    pthread_mutex_lock(&q->lock);
+    q->stop = 1;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+
+    for (int i = 0; i < MESH_REPL_SENDERS; i++) pthread_join(q->senders[i], NULL);
+
+    /* Spill anything still pending so it is retried after restart */
+    pthread_mutex_lock(&q->lock);
+    mesh_repl_item_t *it = q->head;
+    while (it) {
+        mesh_repl_item_t *n = it->next;
+        mesh_repl_spill_one(q, it);
+        free(it);
+        it = n;
     }
+    q->head = q->tail = NULL;
+    q->count = 0;
+    pthread_mutex_unlock(&q->lock);
 
-    mesh_log_verbose(mesh->config, "mesh: replicate chunk %s done", hashhex);
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    q->started = 0;
+}
+
+int junknas_mesh_replicate_chunk(junknas_mesh_t *mesh,
+                                const char *hashhex,
+                                const char *chunk_path) {
+    if (!mesh || !hashhex || !chunk_path) return -1;
+    if (!junknas_mesh_is_active(mesh)) return -1;
+    if (!mesh->repl.started) return -1;
+
+    mesh_log_verbose(mesh->config, "mesh: queueing chunk %s for replication", hashhex);
+    mesh_repl_enqueue(mesh, hashhex, chunk_path, NULL, 0, 0);
     return 0;
 }
 
@@ -966,6 +1760,8 @@ junknas_mesh_t *junknas_mesh_start(junknas_config_t *config) {
 
     mesh->config = config;
     pthread_mutex_init(&mesh->lock, NULL);
+    pthread_mutex_init(&mesh->stats_lock, NULL);
+    pthread_cond_init(&mesh->stats_cond, NULL);
 
     mesh_log_verbose(config, "mesh: starting mesh services");
     mesh_ensure_local_mount(mesh);
@@ -973,9 +1769,22 @@ junknas_mesh_t *junknas_mesh_start(junknas_config_t *config) {
     junknas_config_lock(mesh->config);
     mesh->last_applied_peers_updated_at = mesh->config->wg_peers_updated_at;
     junknas_config_unlock(mesh->config);
+    (void)mesh_apply_wireguard(mesh);
+
+    if (mesh_repl_start(mesh) != 0) {
+        mesh_log_verbose(config, "mesh: failed to start replication senders");
+        pthread_mutex_destroy(&mesh->stats_lock);
+        pthread_cond_destroy(&mesh->stats_cond);
+        pthread_mutex_destroy(&mesh->lock);
+        free(mesh);
+        return NULL;
+    }
 
     if (pthread_create(&mesh->listener, NULL, mesh_listener_thread, mesh) != 0) {
         mesh_log_verbose(config, "mesh: failed to start mesh listener thread");
+        mesh_repl_stop(mesh);
+        pthread_mutex_destroy(&mesh->stats_lock);
+        pthread_cond_destroy(&mesh->stats_cond);
         pthread_mutex_destroy(&mesh->lock);
         free(mesh);
         return NULL;
@@ -1010,6 +1819,20 @@ void junknas_mesh_stop(junknas_mesh_t *mesh) {
     if (mesh->listener) {
         pthread_join(mesh->listener, NULL);
     }
+    mesh_repl_stop(mesh);
+
+    /* Hedge workers are detached; wait for stragglers before freeing */
+    pthread_mutex_lock(&mesh->stats_lock);
+    while (mesh->fetch_inflight > 0) {
+        pthread_cond_wait(&mesh->stats_cond, &mesh->stats_lock);
+    }
+    pthread_mutex_unlock(&mesh->stats_lock);
+
+    for (int i = 0; i < mesh->inv_count; i++) {
+        free(mesh->invs[i].bits);
+    }
+    pthread_mutex_destroy(&mesh->stats_lock);
+    pthread_cond_destroy(&mesh->stats_cond);
     pthread_mutex_destroy(&mesh->lock);
     free(mesh);
 }
@@ -0,0 +1,168 @@
+/*
+ * junkNAS - operation counters and latency histograms
+ *
+ * Updates land in one of JNK_METRIC_STRIPES cacheline-aligned slots; a
+ * thread picks its stripe once (round-robin on first use) and then every
+ * record is a single relaxed fetch-add on memory no other thread is
+ * likely writing. Histogram buckets are powers of two from 1us up, which
+ * turns bucket selection into a count-leading-zeros. The only code that
+ * walks all stripes is the /metrics scrape.
+ */
+
+#include "metrics.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define JNK_METRIC_STRIPES 16
+#define JNK_HIST_BUCKETS   21   /* 1us, 2us, ... ~1.05s, then +Inf */
+
+typedef struct {
+    _Atomic uint64_t ctr[JNK_CTR_COUNT];
+    _Atomic uint64_t bucket[JNK_HIST_COUNT][JNK_HIST_BUCKETS + 1];
+    _Atomic uint64_t sum_us[JNK_HIST_COUNT];
+    char pad[64];
+} __attribute__((aligned(64))) jnk_metric_stripe_t;
+
+static jnk_metric_stripe_t stripes[JNK_METRIC_STRIPES];
+
+static const char *ctr_names[JNK_CTR_COUNT] = {
+    "jnk_chunk_cache_hits_total",
+    "jnk_chunk_cache_misses_total",
+    "jnk_store_chunks_written_total",
+    "jnk_store_put_dedup_total",
+    "jnk_fuse_read_bytes_total",
+    "jnk_fuse_write_bytes_total",
+    "jnk_mesh_fetch_ok_total",
+    "jnk_mesh_fetch_fail_total",
+    "jnk_mesh_chunks_sent_total",
+};
+
+static const char *hist_names[JNK_HIST_COUNT] = {
+    "jnk_fuse_getattr_latency_seconds",
+    "jnk_fuse_read_latency_seconds",
+    "jnk_fuse_write_latency_seconds",
+    "jnk_fuse_release_latency_seconds",
+    "jnk_chunk_read_latency_seconds",
+    "jnk_chunk_put_latency_seconds",
+    "jnk_mesh_fetch_latency_seconds",
+};
+
+static unsigned my_stripe(void) {
+    static _Atomic unsigned next_stripe;
+    static _Thread_local unsigned stripe = JNK_METRIC_STRIPES;
+
+    if (stripe == JNK_METRIC_STRIPES) {
+        stripe = atomic_fetch_add_explicit(&next_stripe, 1,
+                                           memory_order_relaxed) % JNK_METRIC_STRIPES;
+    }
+    return stripe;
+}
+
+uint64_t jnk_metric_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+void jnk_metric_add(jnk_metric_ctr_t c, uint64_t v) {
+    atomic_fetch_add_explicit(&stripes[my_stripe()].ctr[c], v,
+                              memory_order_relaxed);
+}
+
+/* Smallest i with us <= 1<<i; everything past the last bound is +Inf. */
+static unsigned bucket_for_us(uint64_t us) {
+    if (us <= 1) return 0;
+    unsigned i = (unsigned)(64 - __builtin_clzll(us - 1));
+    return i < JNK_HIST_BUCKETS ? i : JNK_HIST_BUCKETS;
+}
+
+void jnk_metric_observe_us(jnk_metric_hist_t h, uint64_t us) {
+    jnk_metric_stripe_t *s = &stripes[my_stripe()];
+    atomic_fetch_add_explicit(&s->bucket[h][bucket_for_us(us)], 1,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&s->sum_us[h], us, memory_order_relaxed);
+}
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+    int oom;
+} render_buf_t;
+
+static void render_appendf(render_buf_t *r, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void render_appendf(render_buf_t *r, const char *fmt, ...) {
+    if (r->oom) return;
+    for (;;) {
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(r->buf + r->len, r->cap - r->len, fmt, args);
+        va_end(args);
+        if (n < 0) { r->oom = 1; return; }
+        if ((size_t)n < r->cap - r->len) { r->len += (size_t)n; return; }
+        size_t cap = r->cap * 2;
+        char *grown = realloc(r->buf, cap);
+        if (!grown) { r->oom = 1; return; }
+        r->buf = grown;
+        r->cap = cap;
+    }
+}
+
+char *jnk_metrics_render(void) {
+    render_buf_t r = {0};
+    r.cap = 16384;
+    r.buf = malloc(r.cap);
+    if (!r.buf) return NULL;
+    r.buf[0] = '\0';
+
+    for (int c = 0; c < JNK_CTR_COUNT; c++) {
+        uint64_t total = 0;
+        for (int s = 0; s < JNK_METRIC_STRIPES; s++) {
+            total += atomic_load_explicit(&stripes[s].ctr[c],
+                                          memory_order_relaxed);
+        }
+        render_appendf(&r, "# TYPE %s counter\n%s %" PRIu64 "\n",
+                       ctr_names[c], ctr_names[c], total);
+    }
+
+    for (int h = 0; h < JNK_HIST_COUNT; h++) {
+        uint64_t cum = 0, sum_us = 0;
+        render_appendf(&r, "# TYPE %s histogram\n", hist_names[h]);
+        for (int b = 0; b <= JNK_HIST_BUCKETS; b++) {
+            uint64_t n = 0;
+            for (int s = 0; s < JNK_METRIC_STRIPES; s++) {
+                n += atomic_load_explicit(&stripes[s].bucket[h][b],
+                                          memory_order_relaxed);
+            }
+            cum += n;
+            if (b < JNK_HIST_BUCKETS) {
+                render_appendf(&r, "%s_bucket{le=\"%g\"} %" PRIu64 "\n",
+                               hist_names[h], (double)(1ull << b) / 1e6, cum);
+            } else {
+                render_appendf(&r, "%s_bucket{le=\"+Inf\"} %" PRIu64 "\n",
+                               hist_names[h], cum);
+            }
+        }
+        for (int s = 0; s < JNK_METRIC_STRIPES; s++) {
+            sum_us += atomic_load_explicit(&stripes[s].sum_us[h],
+                                           memory_order_relaxed);
+        }
+        render_appendf(&r, "%s_sum %g\n%s_count %" PRIu64 "\n",
+                       hist_names[h], (double)sum_us / 1e6,
+                       hist_names[h], cum);
+    }
+
+    if (r.oom) {
+        free(r.buf);
+        return NULL;
+    }
+    return r.buf;
+}
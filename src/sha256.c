@@ -0,0 +1,313 @@
+/*
+ * junkNAS - SHA-256 with runtime-dispatched hardware acceleration
+ *
+ * The scalar implementation below is the original minimal public-domain
+ * style code that used to live in fuse_fs.c. Chunk hashing sits on the
+ * critical path of every verified read and every commit, so on CPUs that
+ * have dedicated SHA instructions (x86-64 SHA-NI, ARMv8 crypto
+ * extensions) we swap in a hardware compression function, detected once
+ * on first use. All variants produce identical digests.
+ */
+
+#include "sha256.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA256_HAVE_SHANI 1
+#endif
+
+#if defined(__aarch64__) && defined(__GNUC__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+#define SHA256_HAVE_ARMCE 1
+#endif
+
+static const uint32_t K256[64] = {
+    0x428a2f98u,0x71374491u,0xb5c0fbcfu,0xe9b5dba5u,0x3956c25bu,0x59f111f1u,0x923f82a4u,0xab1c5ed5u,
+    0xd807aa98u,0x12835b01u,0x243185beu,0x550c7dc3u,0x72be5d74u,0x80deb1feu,0x9bdc06a7u,0xc19bf174u,
+    0xe49b69c1u,0xefbe4786u,0x0fc19dc6u,0x240ca1ccu,0x2de92c6fu,0x4a7484aau,0x5cb0a9dcu,0x76f988dau,
+    0x983e5152u,0xa831c66du,0xb00327c8u,0xbf597fc7u,0xc6e00bf3u,0xd5a79147u,0x06ca6351u,0x14292967u,
+    0x27b70a85u,0x2e1b2138u,0x4d2c6dfcu,0x53380d13u,0x650a7354u,0x766a0abbu,0x81c2c92eu,0x92722c85u,
+    0xa2bfe8a1u,0xa81a664bu,0xc24b8b70u,0xc76c51a3u,0xd192e819u,0xd6990624u,0xf40e3585u,0x106aa070u,
+    0x19a4c116u,0x1e376c08u,0x2748774cu,0x34b0bcb5u,0x391c0cb3u,0x4ed8aa4au,0x5b9cca4fu,0x682e6ff3u,
+    0x748f82eeu,0x78a5636fu,0x84c87814u,0x8cc70208u,0x90befffau,0xa4506cebu,0xbef9a3f7u,0xc67178f2u
+};
+
+/* ---------------------------- Scalar fallback --------------------------- */
+
+static uint32_t rotr32(uint32_t x, uint32_t n) { return (x >> n) | (x << (32 - n)); }
+
+static void sha256_compress_scalar(uint32_t state[8], const uint8_t block[64]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i*4+0] << 24) | ((uint32_t)block[i*4+1] << 16) |
+               ((uint32_t)block[i*4+2] << 8)  | ((uint32_t)block[i*4+3]);
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr32(w[i-15], 7) ^ rotr32(w[i-15], 18) ^ (w[i-15] >> 3);
+        uint32_t s1 = rotr32(w[i-2], 17) ^ rotr32(w[i-2], 19) ^ (w[i-2] >> 10);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+
+    uint32_t a=state[0], b=state[1], d=state[3], e=state[4], f=state[5], g=state[6], h=state[7], cc=state[2];
+
+    for (int i = 0; i < 64; i++) {
+        uint32_t S1 = rotr32(e,6) ^ rotr32(e,11) ^ rotr32(e,25);
+        uint32_t ch = (e & f) ^ ((~e) & g);
+        uint32_t temp1 = h + S1 + ch + K256[i] + w[i];
+        uint32_t S0 = rotr32(a,2) ^ rotr32(a,13) ^ rotr32(a,22);
+        uint32_t maj = (a & b) ^ (a & cc) ^ (b & cc);
+        uint32_t temp2 = S0 + maj;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = cc;
+        cc = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    state[0]+=a; state[1]+=b; state[2]+=cc; state[3]+=d;
+    state[4]+=e; state[5]+=f; state[6]+=g; state[7]+=h;
+}
+
+/* ------------------------------ x86 SHA-NI ------------------------------ */
+
+#ifdef SHA256_HAVE_SHANI
+
+__attribute__((target("sha,sse4.1")))
+static void sha256_compress_shani(uint32_t state[8], const uint8_t block[64]) {
+    __m128i STATE0, STATE1, MSG, TMP;
+    __m128i ABEF_SAVE, CDGH_SAVE;
+    const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    /* Load initial state and rearrange into the ABEF/CDGH layout */
+    TMP    = _mm_loadu_si128((const __m128i *)&state[0]);
+    STATE1 = _mm_loadu_si128((const __m128i *)&state[4]);
+
+    TMP    = _mm_shuffle_epi32(TMP, 0xB1);          /* CDAB */
+    STATE1 = _mm_shuffle_epi32(STATE1, 0x1B);       /* EFGH */
+    STATE0 = _mm_alignr_epi8(TMP, STATE1, 8);       /* ABEF */
+    STATE1 = _mm_blend_epi16(STATE1, TMP, 0xF0);    /* CDGH */
+
+    ABEF_SAVE = STATE0;
+    CDGH_SAVE = STATE1;
+
+    /* 16 groups of 4 rounds; the message ring m[] holds W[4g..4g+3].
+     * For g >= 4: W_g = msg2(msg1(W_{g-4}, W_{g-3}) + alignr(W_{g-1}, W_{g-2}), W_{g-1}) */
+    __m128i m[4];
+    for (int g = 0; g < 16; g++) {
+        if (g < 4) {
+            MSG = _mm_loadu_si128((const __m128i *)(block + 16 * g));
+            m[g] = _mm_shuffle_epi8(MSG, MASK);
+        } else {
+            TMP = _mm_alignr_epi8(m[(g + 3) & 3], m[(g + 2) & 3], 4);
+            m[g & 3] = _mm_sha256msg2_epu32(
+                _mm_add_epi32(_mm_sha256msg1_epu32(m[g & 3], m[(g + 1) & 3]), TMP),
+                m[(g + 3) & 3]);
+        }
+        MSG = _mm_add_epi32(m[g & 3], _mm_loadu_si128((const __m128i *)&K256[4 * g]));
+        STATE1 = _mm_sha256rnds2_epu32(STATE1, STATE0, MSG);
+        MSG = _mm_shuffle_epi32(MSG, 0x0E);
+        STATE0 = _mm_sha256rnds2_epu32(STATE0, STATE1, MSG);
+    }
+
+    STATE0 = _mm_add_epi32(STATE0, ABEF_SAVE);
+    STATE1 = _mm_add_epi32(STATE1, CDGH_SAVE);
+
+    /* Rearrange back to the canonical a..h order */
+    TMP    = _mm_shuffle_epi32(STATE0, 0x1B);       /* FEBA */
+    STATE1 = _mm_shuffle_epi32(STATE1, 0xB1);       /* DCHG */
+    STATE0 = _mm_blend_epi16(TMP, STATE1, 0xF0);    /* DCBA */
+    STATE1 = _mm_alignr_epi8(STATE1, TMP, 8);       /* HGFE */
+
+    _mm_storeu_si128((__m128i *)&state[0], STATE0);
+    _mm_storeu_si128((__m128i *)&state[4], STATE1);
+}
+
+static int cpu_has_shani(void) {
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return 0;
+    return (ebx & (1u << 29)) != 0; /* CPUID.(EAX=7,ECX=0):EBX.SHA[bit 29] */
+}
+
+#endif /* SHA256_HAVE_SHANI */
+
+/* ---------------------------- ARMv8 crypto ------------------------------ */
+
+#ifdef SHA256_HAVE_ARMCE
+
+__attribute__((target("+crypto")))
+static void sha256_compress_armce(uint32_t state[8], const uint8_t block[64]) {
+    uint32x4_t s0 = vld1q_u32(&state[0]);
+    uint32x4_t s1 = vld1q_u32(&state[4]);
+    const uint32x4_t s0_save = s0;
+    const uint32x4_t s1_save = s1;
+
+    uint32x4_t m[4];
+    m[0] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block + 0)));
+    m[1] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block + 16)));
+    m[2] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block + 32)));
+    m[3] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(block + 48)));
+
+    uint32x4_t w = vaddq_u32(m[0], vld1q_u32(&K256[0]));
+
+    /* Rounds 0-47: message schedule still running */
+    for (int r = 0; r < 12; r++) {
+        uint32x4_t w_next = vaddq_u32(m[(r + 1) & 3], vld1q_u32(&K256[4 * (r + 1)]));
+        uint32x4_t t = s0;
+        s0 = vsha256hq_u32(s0, s1, w);
+        s1 = vsha256h2q_u32(s1, t, w);
+        m[r & 3] = vsha256su1q_u32(vsha256su0q_u32(m[r & 3], m[(r + 1) & 3]),
+                                   m[(r + 2) & 3], m[(r + 3) & 3]);
+        w = w_next;
+    }
+
+    /* Rounds 48-63 */
+    for (int r = 12; r < 16; r++) {
+        uint32x4_t w_next = (r < 15)
+            ? vaddq_u32(m[(r + 1) & 3], vld1q_u32(&K256[4 * (r + 1)]))
+            : w;
+        uint32x4_t t = s0;
+        s0 = vsha256hq_u32(s0, s1, w);
+        s1 = vsha256h2q_u32(s1, t, w);
+        w = w_next;
+    }
+
+    vst1q_u32(&state[0], vaddq_u32(s0, s0_save));
+    vst1q_u32(&state[4], vaddq_u32(s1, s1_save));
+}
+
+static int cpu_has_armce(void) {
+    return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+}
+
+#endif /* SHA256_HAVE_ARMCE */
+
+/* ---------------------------- Dispatch ---------------------------------- */
+
+typedef void (*sha256_compress_fn)(uint32_t state[8], const uint8_t block[64]);
+
+static sha256_compress_fn sha256_compress = NULL;
+static const char *sha256_impl = "scalar";
+
+static void sha256_select_impl(void) {
+    if (sha256_compress) return;
+
+#ifdef SHA256_HAVE_SHANI
+    if (cpu_has_shani()) {
+        sha256_compress = sha256_compress_shani;
+        sha256_impl = "sha-ni";
+        return;
+    }
+#endif
+#ifdef SHA256_HAVE_ARMCE
+    if (cpu_has_armce()) {
+        sha256_compress = sha256_compress_armce;
+        sha256_impl = "armv8-ce";
+        return;
+    }
+#endif
+    sha256_compress = sha256_compress_scalar;
+    sha256_impl = "scalar";
+}
+
+const char *sha256_impl_name(void) {
+    sha256_select_impl();
+    return sha256_impl;
+}
+
+/* ------------------------------ Public API ------------------------------ */
+
+void sha256_init(sha256_ctx *c) {
+    sha256_select_impl();
+    c->h[0] = 0x6a09e667u; c->h[1] = 0xbb67ae85u; c->h[2] = 0x3c6ef372u; c->h[3] = 0xa54ff53au;
+    c->h[4] = 0x510e527fu; c->h[5] = 0x9b05688cu; c->h[6] = 0x1f83d9abu; c->h[7] = 0x5be0cd19u;
+    c->len_bits = 0;
+    c->buf_len = 0;
+}
+
+void sha256_update(sha256_ctx *c, const void *data, size_t n) {
+    const uint8_t *p = (const uint8_t *)data;
+    c->len_bits += (uint64_t)n * 8u;
+
+    /* Fast path: whole blocks straight from the caller's buffer */
+    if (c->buf_len == 0) {
+        while (n >= 64) {
+            sha256_compress(c->h, p);
+            p += 64;
+            n -= 64;
+        }
+    }
+
+    while (n > 0) {
+        size_t room = 64 - c->buf_len;
+        size_t take = (n < room) ? n : room;
+        memcpy(c->buf + c->buf_len, p, take);
+        c->buf_len += take;
+        p += take;
+        n -= take;
+
+        if (c->buf_len == 64) {
+            sha256_compress(c->h, c->buf);
+            c->buf_len = 0;
+            /* Back to the fast path for any remaining whole blocks */
+            while (n >= 64) {
+                sha256_compress(c->h, p);
+                p += 64;
+                n -= 64;
+            }
+        }
+    }
+}
+
+void sha256_final(sha256_ctx *c, uint8_t out[32]) {
+    /* pad */
+    c->buf[c->buf_len++] = 0x80;
+    if (c->buf_len > 56) {
+        while (c->buf_len < 64) c->buf[c->buf_len++] = 0x00;
+        sha256_compress(c->h, c->buf);
+        c->buf_len = 0;
+    }
+    while (c->buf_len < 56) c->buf[c->buf_len++] = 0x00;
+
+    /* length big-endian */
+    uint64_t L = c->len_bits;
+    for (int i = 7; i >= 0; i--) {
+        c->buf[c->buf_len++] = (uint8_t)((L >> (i*8)) & 0xffu);
+    }
+    sha256_compress(c->h, c->buf);
+
+    for (int i = 0; i < 8; i++) {
+        out[i*4+0] = (uint8_t)((c->h[i] >> 24) & 0xffu);
+        out[i*4+1] = (uint8_t)((c->h[i] >> 16) & 0xffu);
+        out[i*4+2] = (uint8_t)((c->h[i] >> 8) & 0xffu);
+        out[i*4+3] = (uint8_t)((c->h[i]) & 0xffu);
+    }
+}
+
+void sha256_hex(const uint8_t digest[32], char hex[65]) {
+    static const char *H = "0123456789abcdef";
+    for (int i = 0; i < 32; i++) {
+        hex[i*2+0] = H[(digest[i] >> 4) & 0xF];
+        hex[i*2+1] = H[digest[i] & 0xF];
+    }
+    hex[64] = '\0';
+}
+
+void sha256_buf_hex(const void *data, size_t n, char hex[65]) {
+    sha256_ctx c;
+    uint8_t d[32];
+    sha256_init(&c);
+    sha256_update(&c, data, n);
+    sha256_final(&c, d);
+    sha256_hex(d, hex);
+}
@@ -2,8 +2,16 @@
  * junkNAS - Minimal web server for browsing and chunk sync
  */
 
+#define _GNU_SOURCE                    /* O_TMPFILE */
+
 #include "web_server.h"
 
+#include "chunk_inventory.h"
+#include "compress.h"
+#include "http_client.h"
+#include "metrics.h"
+#include "sha256.h"
+
 #include <arpa/inet.h>
 #include <ctype.h>
 #include <dirent.h>
@@ -17,6 +25,8 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/time.h>
@@ -30,16 +40,48 @@
 #define WEB_BACKLOG 16
 #define WEB_BUF_SIZE 8192
 
+/* Event loop tuning */
+#define WEB_WORKERS       4    /* fixed pool running the protocol handlers */
+#define WEB_PENDING_MAX   256  /* readable sockets queued for workers */
+#define WEB_EPOLL_EVENTS  64   /* events drained per epoll_wait */
+#define WEB_IO_TIMEOUT_SEC 30  /* per-socket read/write timeout in workers */
+#define WEB_IDLE_MAX      256  /* keep-alive sockets parked back in epoll */
+
+/* Batched chunk transfer limits */
+#define WEB_BATCH_MAX        256            /* hashes per batch request */
+#define WEB_BATCH_CHUNK_MAX  (64u << 20)    /* sanity cap per chunk payload */
+
+/* Chunk payload I/O */
+#define WEB_SENDFILE_MAX     (1u << 20)     /* bytes per sendfile() call */
+#define WEB_INGEST_BUF       (256u << 10)   /* aligned upload read size */
+
 struct junknas_web_server {
     junknas_config_t *config;
     int fd;
+    int epoll_fd;
     pthread_t thread;
     int stop;
+    pthread_t workers[WEB_WORKERS];
+    int worker_count;
+    pthread_mutex_t ready_lock;        /* guards the ready ring below */
+    pthread_cond_t ready_cond;
+    int ready[WEB_PENDING_MAX];        /* readable sockets awaiting a worker */
+    int ready_head;
+    int ready_count;
+    pthread_mutex_t idle_lock;         /* guards the parked-socket table */
+    struct {
+        int fd;
+        time_t deadline;
+    } idle[WEB_IDLE_MAX];              /* keep-alive sockets waiting in epoll */
+    int idle_count;
 };
 
 typedef struct {
     int fd;
     junknas_config_t *config;
+    int keep_alive;                    /* may serve another request after this */
+    int body_unread;                   /* request body bytes may still sit
+                                        * unread on the socket */
 } web_conn_t;
 
 static const char qr_lib_js[] __attribute__((unused)) =
@@ -89,41 +131,55 @@ static void send_all(int fd, const char *data) {
     send(fd, data, strlen(data), 0);
 }
 
-static void send_status(int fd, int code, const char *message) {
+/* Connection header for a response with exact framing. An error response
+ * only forces a close when request body bytes may be left unread on the
+ * socket (they would be misparsed as the next request); errors on
+ * body-less requests -- a chunk-probe 404 being the routine case -- keep
+ * the pooled connection warm. */
+static const char *conn_header(const web_conn_t *conn) {
+    return conn->keep_alive ? "keep-alive" : "close";
+}
+
+static void send_status(web_conn_t *conn, int code, const char *message) {
+    if (code >= 400 && conn->body_unread) conn->keep_alive = 0;
     char buf[128];
-    snprintf(buf, sizeof(buf), "HTTP/1.1 %d %s\r\nConnection: close\r\n\r\n", code, message);
-    send_all(fd, buf);
+    snprintf(buf, sizeof(buf), "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: %s\r\n\r\n",
+             code, message, conn_header(conn));
+    send_all(conn->fd, buf);
 }
 
-static void send_text(int fd, int code, const char *body) {
+static void send_text(web_conn_t *conn, int code, const char *body) {
     char header[256];
     size_t len = body ? strlen(body) : 0;
     snprintf(header, sizeof(header),
-             "HTTP/1.1 %d OK\r\nContent-Type: text/plain\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
-             code, len);
-    send_all(fd, header);
-    if (body) send(fd, body, len, 0);
+             "HTTP/1.1 %d OK\r\nContent-Type: text/plain\r\nContent-Length: %zu\r\nConnection: %s\r\n\r\n",
+             code, len, conn_header(conn));
+    send_all(conn->fd, header);
+    if (body) send(conn->fd, body, len, 0);
 }
 
-static void send_json(int fd, int code, const char *body) {
+static void send_json(web_conn_t *conn, int code, const char *body) {
     char header[256];
     size_t len = body ? strlen(body) : 0;
     snprintf(header, sizeof(header),
-             "HTTP/1.1 %d OK\r\nContent-Type: application/json\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
-             code, len);
-    send_all(fd, header);
-    if (body) send(fd, body, len, 0);
+             "HTTP/1.1 %d OK\r\nContent-Type: application/json\r\nContent-Length: %zu\r\nConnection: %s\r\n\r\n",
+             code, len, conn_header(conn));
+    send_all(conn->fd, header);
+    if (body) send(conn->fd, body, len, 0);
 }
 
-static void send_html_header(int fd, const char *title) {
+static void send_html_header(web_conn_t *conn, const char *title) {
+    /* HTML pages are streamed without a Content-Length, so the close is
+     * what delimits them. */
+    conn->keep_alive = 0;
     char header[256];
     snprintf(header, sizeof(header),
              "HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\nConnection: close\r\n\r\n");
-    send_all(fd, header);
-    send_all(fd, "<!doctype html><html><head><meta charset=\"utf-8\">");
-    send_all(fd, "<title>");
-    send_all(fd, title ? title : "junkNAS");
-    send_all(fd, "</title></head><body>");
+    send_all(conn->fd, header);
+    send_all(conn->fd, "<!doctype html><html><head><meta charset=\"utf-8\">");
+    send_all(conn->fd, "<title>");
+    send_all(conn->fd, title ? title : "junkNAS");
+    send_all(conn->fd, "</title></head><body>");
 }
 
 static void send_html_footer(int fd) {
@@ -158,25 +214,29 @@ static cJSON *peer_to_json(const junknas_wg_peer_t *peer) {
 }
 
 static cJSON *build_mesh_state_json(junknas_config_t *config) {
+    junknas_config_snapshot_t *snap = junknas_config_snapshot_get(config);
+    if (!snap) return NULL;
     cJSON *root = cJSON_CreateObject();
-    if (!root) return NULL;
+    if (!root) {
+        junknas_config_snapshot_put(snap);
+        return NULL;
+    }
 
-    junknas_config_lock(config);
-    if (strcmp(config->node_state, NODE_STATE_NODE) == 0) {
-        cJSON_AddNumberToObject(root, "updated_at", (double)config->wg_peers_updated_at);
-        cJSON_AddNumberToObject(root, "mounts_updated_at", (double)config->data_mount_points_updated_at);
+    if (strcmp(snap->node_state, NODE_STATE_NODE) == 0) {
+        cJSON_AddNumberToObject(root, "updated_at", (double)snap->wg_peers_updated_at);
+        cJSON_AddNumberToObject(root, "mounts_updated_at", (double)snap->data_mount_points_updated_at);
 
         cJSON *self = cJSON_CreateObject();
         if (self) {
-            cJSON_AddStringToObject(self, "endpoint", config->wg.endpoint);
-            cJSON_AddNumberToObject(self, "web_port", (double)config->web_port);
+            cJSON_AddStringToObject(self, "endpoint", snap->wg.endpoint);
+            cJSON_AddNumberToObject(self, "web_port", (double)snap->web_port);
             cJSON_AddItemToObject(root, "self", self);
         }
 
         cJSON *peers = cJSON_CreateArray();
         if (peers) {
-            for (int i = 0; i < config->wg_peer_count; i++) {
-                cJSON *peer = peer_to_json(&config->wg_peers[i]);
+            for (int i = 0; i < snap->wg_peer_count; i++) {
+                cJSON *peer = peer_to_json(&snap->wg_peers[i]);
                 if (peer) cJSON_AddItemToArray(peers, peer);
             }
             cJSON_AddItemToObject(root, "peers", peers);
@@ -184,8 +244,8 @@ static cJSON *build_mesh_state_json(junknas_config_t *config) {
 
         cJSON *mounts = cJSON_CreateArray();
         if (mounts) {
-            for (int i = 0; i < config->data_mount_point_count; i++) {
-                cJSON_AddItemToArray(mounts, cJSON_CreateString(config->data_mount_points[i]));
+            for (int i = 0; i < snap->data_mount_point_count; i++) {
+                cJSON_AddItemToArray(mounts, cJSON_CreateString(snap->data_mount_points[i]));
             }
             cJSON_AddItemToObject(root, "mount_points", mounts);
         }
@@ -193,24 +253,24 @@ static cJSON *build_mesh_state_json(junknas_config_t *config) {
         cJSON_AddNumberToObject(root, "updated_at", 0.0);
         cJSON_AddNumberToObject(root, "mounts_updated_at", 0.0);
     }
-    junknas_config_unlock(config);
+    junknas_config_snapshot_put(snap);
     return root;
 }
 
-static void respond_mesh_state(int fd, junknas_config_t *config) {
-    cJSON *root = build_mesh_state_json(config);
+static void respond_mesh_state(web_conn_t *conn) {
+    cJSON *root = build_mesh_state_json(conn->config);
     if (!root) {
-        send_status(fd, 500, "Error");
+        send_status(conn, 500, "Error");
         return;
     }
 
     char *printed = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
     if (!printed) {
-        send_status(fd, 500, "Error");
+        send_status(conn, 500, "Error");
         return;
     }
-    send_json(fd, 200, printed);
+    send_json(conn, 200, printed);
     free(printed);
 }
 
@@ -231,26 +291,6 @@ static int parse_endpoint(const char *endpoint, char *host, size_t host_len, uin
     return 0;
 }
 
-static int resolve_addr(const char *host, uint16_t port, int socktype,
-                        struct sockaddr_storage *out, socklen_t *out_len) {
-    if (!host || !out || !out_len) return -1;
-    char port_str[8];
-    snprintf(port_str, sizeof(port_str), "%u", port);
-
-    struct addrinfo hints;
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_socktype = socktype;
-    hints.ai_family = AF_UNSPEC;
-
-    struct addrinfo *res = NULL;
-    if (getaddrinfo(host, port_str, &hints, &res) != 0) return -1;
-    if (!res) return -1;
-    memcpy(out, res->ai_addr, res->ai_addrlen);
-    *out_len = (socklen_t)res->ai_addrlen;
-    freeaddrinfo(res);
-    return 0;
-}
-
 static int update_wg_peer_by_ip(junknas_config_t *config, const junknas_wg_peer_t *peer) {
     if (!config || !peer || peer->endpoint[0] == '\0') return -1;
 
@@ -266,149 +306,56 @@ static int update_wg_peer_by_ip(junknas_config_t *config, const junknas_wg_peer_
     return 1;
 }
 
-static char *http_request_body(const char *host, uint16_t port, const char *request,
-                               const char *body, size_t body_len, int *out_status) {
-    struct sockaddr_storage addr;
-    socklen_t addr_len = 0;
-    if (resolve_addr(host, port, SOCK_STREAM, &addr, &addr_len) != 0) return NULL;
-
-    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
-    if (fd < 0) return NULL;
-
-    struct timeval timeout;
-    timeout.tv_sec = 1;
-    timeout.tv_usec = 0;
-    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
-
-    if (connect(fd, (struct sockaddr *)&addr, addr_len) != 0) {
-        close(fd);
-        return NULL;
-    }
-
-    if (send(fd, request, strlen(request), 0) < 0) {
-        close(fd);
-        return NULL;
-    }
-    if (body && body_len > 0) {
-        if (send(fd, body, body_len, 0) < 0) {
-            close(fd);
-            return NULL;
-        }
-    }
-
-    char buf[4096];
-    char header_buf[8192 + 1];
-    size_t header_used = 0;
-    int status = 0;
-    int header_done = 0;
-    char *out = NULL;
-    size_t out_len = 0;
-
-    while (1) {
-        ssize_t n = recv(fd, buf, sizeof(buf), 0);
-        if (n <= 0) break;
-
-        if (!header_done) {
-            size_t to_copy = (size_t)n;
-            if (header_used + to_copy > sizeof(header_buf)) {
-                to_copy = sizeof(header_buf) - header_used;
-            }
-            memcpy(header_buf + header_used, buf, to_copy);
-            header_used += to_copy;
-
-            char *header_end = NULL;
-            for (size_t i = 0; i + 3 < header_used; i++) {
-                if (header_buf[i] == '\r' && header_buf[i + 1] == '\n' &&
-                    header_buf[i + 2] == '\r' && header_buf[i + 3] == '\n') {
-                    header_end = header_buf + i + 4;
-                    size_t header_len = i + 4;
-                    if (header_len < sizeof(header_buf)) {
-                        header_buf[header_len] = '\0';
-                    } else {
-                        header_buf[sizeof(header_buf) - 1] = '\0';
-                    }
-                    char *line_end = strstr(header_buf, "\r\n");
-                    if (line_end) {
-                        *line_end = '\0';
-                        (void)sscanf(header_buf, "HTTP/%*s %d", &status);
-                    }
-                    header_done = 1;
-                    size_t body_part = header_used - header_len;
-                    if (body_part > 0) {
-                        char *new_out = realloc(out, out_len + body_part + 1);
-                        if (!new_out) break;
-                        out = new_out;
-                        memcpy(out + out_len, header_end, body_part);
-                        out_len += body_part;
-                        out[out_len] = '\0';
-                    }
-                    break;
-                }
-            }
-        } else {
-            char *new_out = realloc(out, out_len + (size_t)n + 1);
-            if (!new_out) break;
-            out = new_out;
-            memcpy(out + out_len, buf, (size_t)n);
-            out_len += (size_t)n;
-            out[out_len] = '\0';
-        }
-    }
-
-    close(fd);
-    if (out_status) *out_status = status;
-    if (!out) {
-        out = calloc(1, 1);
+static void respond_mesh_config(web_conn_t *conn) {
+    junknas_config_snapshot_t *snap = junknas_config_snapshot_get(conn->config);
+    if (!snap) {
+        send_status(conn, 500, "Error");
+        return;
     }
-    return out;
-}
-
-static void respond_mesh_config(int fd, junknas_config_t *config) {
     cJSON *root = cJSON_CreateObject();
     if (!root) {
-        send_status(fd, 500, "Error");
+        junknas_config_snapshot_put(snap);
+        send_status(conn, 500, "Error");
         return;
     }
 
-    junknas_config_lock(config);
     cJSON *self = cJSON_CreateObject();
     if (self) {
-        cJSON_AddStringToObject(self, "endpoint", config->wg.endpoint);
-        cJSON_AddNumberToObject(self, "web_port", (double)config->web_port);
+        cJSON_AddStringToObject(self, "endpoint", snap->wg.endpoint);
+        cJSON_AddNumberToObject(self, "web_port", (double)snap->web_port);
         cJSON_AddItemToObject(root, "self", self);
     }
 
-    cJSON_AddStringToObject(root, "node_state", config->node_state);
+    cJSON_AddStringToObject(root, "node_state", snap->node_state);
     cJSON_AddNumberToObject(root, "bootstrap_peers_updated_at",
-                            (double)config->bootstrap_peers_updated_at);
+                            (double)snap->bootstrap_peers_updated_at);
     cJSON *bootstrap = cJSON_CreateArray();
     if (bootstrap) {
-        for (int i = 0; i < config->bootstrap_peer_count; i++) {
-            cJSON_AddItemToArray(bootstrap, cJSON_CreateString(config->bootstrap_peers[i]));
+        for (int i = 0; i < snap->bootstrap_peer_count; i++) {
+            cJSON_AddItemToArray(bootstrap, cJSON_CreateString(snap->bootstrap_peers[i]));
         }
         cJSON_AddItemToObject(root, "bootstrap_peers", bootstrap);
     }
 
     cJSON_AddNumberToObject(root, "wg_peers_updated_at",
-                            (double)config->wg_peers_updated_at);
+                            (double)snap->wg_peers_updated_at);
     cJSON *peers = cJSON_CreateArray();
     if (peers) {
-        for (int i = 0; i < config->wg_peer_count; i++) {
-            cJSON *peer = peer_to_json(&config->wg_peers[i]);
+        for (int i = 0; i < snap->wg_peer_count; i++) {
+            cJSON *peer = peer_to_json(&snap->wg_peers[i]);
             if (peer) cJSON_AddItemToArray(peers, peer);
         }
         cJSON_AddItemToObject(root, "wg_peers", peers);
     }
-    junknas_config_unlock(config);
+    junknas_config_snapshot_put(snap);
 
     char *printed = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
     if (!printed) {
-        send_status(fd, 500, "Error");
+        send_status(conn, 500, "Error");
         return;
     }
-    send_json(fd, 200, printed);
+    send_json(conn, 200, printed);
     free(printed);
 }
 
@@ -418,26 +365,31 @@ static const char *status_label(int status) {
     return "connecting";
 }
 
-static void respond_mesh_status(int fd, junknas_config_t *config) {
+static void respond_mesh_status(web_conn_t *conn) {
+    junknas_config_snapshot_t *snap = junknas_config_snapshot_get(conn->config);
+    if (!snap) {
+        send_status(conn, 500, "Error");
+        return;
+    }
     cJSON *root = cJSON_CreateObject();
     if (!root) {
-        send_status(fd, 500, "Error");
+        junknas_config_snapshot_put(snap);
+        send_status(conn, 500, "Error");
         return;
     }
 
-    junknas_config_lock(config);
-    int bootstrap_count = config->bootstrap_peer_count;
-    int wg_count = config->wg_peer_count;
+    int bootstrap_count = snap->bootstrap_peer_count;
+    int wg_count = snap->wg_peer_count;
     int any_reachable = 0;
     for (int i = 0; i < bootstrap_count; i++) {
-        if (config->bootstrap_peer_status[i] == 1) {
+        if (snap->bootstrap_peer_status[i] == 1) {
             any_reachable = 1;
             break;
         }
     }
     if (!any_reachable) {
         for (int i = 0; i < wg_count; i++) {
-            if (config->wg_peer_status[i] == 1) {
+            if (snap->wg_peer_status[i] == 1) {
                 any_reachable = 1;
                 break;
             }
@@ -457,8 +409,8 @@ static void respond_mesh_status(int fd, junknas_config_t *config) {
         for (int i = 0; i < bootstrap_count; i++) {
             cJSON *entry = cJSON_CreateObject();
             if (!entry) continue;
-            cJSON_AddStringToObject(entry, "endpoint", config->bootstrap_peers[i]);
-            cJSON_AddStringToObject(entry, "status", status_label(config->bootstrap_peer_status[i]));
+            cJSON_AddStringToObject(entry, "endpoint", snap->bootstrap_peers[i]);
+            cJSON_AddStringToObject(entry, "status", status_label(snap->bootstrap_peer_status[i]));
             cJSON_AddItemToArray(bootstrap, entry);
         }
         cJSON_AddItemToObject(root, "bootstrap_peers", bootstrap);
@@ -469,30 +421,30 @@ static void respond_mesh_status(int fd, junknas_config_t *config) {
         for (int i = 0; i < wg_count; i++) {
             cJSON *entry = cJSON_CreateObject();
             if (!entry) continue;
-            cJSON_AddStringToObject(entry, "endpoint", config->wg_peers[i].endpoint);
+            cJSON_AddStringToObject(entry, "endpoint", snap->wg_peers[i].endpoint);
             cJSON_AddNumberToObject(entry, "web_port",
-                                    (double)(config->wg_peers[i].web_port ? config->wg_peers[i].web_port
-                                                                          : config->web_port));
-            cJSON_AddStringToObject(entry, "status", status_label(config->wg_peer_status[i]));
+                                    (double)(snap->wg_peers[i].web_port ? snap->wg_peers[i].web_port
+                                                                        : snap->web_port));
+            cJSON_AddStringToObject(entry, "status", status_label(snap->wg_peer_status[i]));
             cJSON_AddItemToArray(wg, entry);
         }
         cJSON_AddItemToObject(root, "wg_peers", wg);
     }
-    junknas_config_unlock(config);
+    junknas_config_snapshot_put(snap);
 
     char *printed = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
     if (!printed) {
-        send_status(fd, 500, "Error");
+        send_status(conn, 500, "Error");
         return;
     }
-    send_json(fd, 200, printed);
+    send_json(conn, 200, printed);
     free(printed);
 }
 
-static void respond_mesh_ui(int fd) {
-    send_html_header(fd, "junkNAS mesh");
-    send_all(fd,
+static void respond_mesh_ui(web_conn_t *conn) {
+    send_html_header(conn, "junkNAS mesh");
+    send_all(conn->fd,
              "<style>"
              "body{font-family:Arial,sans-serif;margin:20px;color:#222;}"
              "h1{margin-bottom:4px;} .status{padding:8px 12px;border-radius:6px;margin:10px 0;}"
@@ -516,15 +468,15 @@ static void respond_mesh_ui(int fd) {
              "padding:4px 8px;cursor:pointer;}"
              ".remove-peer:hover{background:#ffd6d6;}"
              "</style>");
-    send_all(fd, "<h1>junkNAS mesh settings</h1>");
-    send_all(fd, "<div id=\"mesh-role\" class=\"status\">Checking mesh status…</div>");
-    send_all(fd, "<section><h2>Local node</h2>"
+    send_all(conn->fd, "<h1>junkNAS mesh settings</h1>");
+    send_all(conn->fd, "<div id=\"mesh-role\" class=\"status\">Checking mesh status…</div>");
+    send_all(conn->fd, "<section><h2>Local node</h2>"
                   "<label>LAN endpoint (IP:PORT)"
                   "<input id=\"self-endpoint\" placeholder=\"192.168.1.10:8080\" />"
                   "</label>"
                   "<div class=\"muted\">Use a LAN IP and the web port for this node.</div>"
                   "<div id=\"self-info\">Loading…</div></section>");
-    send_all(fd, "<section id=\"sync-section\"><h2>Sync new mesh</h2>"
+    send_all(conn->fd, "<section id=\"sync-section\"><h2>Sync new mesh</h2>"
                   "<p>Generate a join config for a new LAN peer and share it securely.</p>"
                   "<div class=\"actions\">"
                   "<button id=\"sync-new\">Sync new mesh</button>"
@@ -534,21 +486,21 @@ static void respond_mesh_ui(int fd) {
                   "<canvas id=\"mesh-qr\" width=\"180\" height=\"180\"></canvas>"
                   "<textarea id=\"join-config\" rows=\"7\" readonly></textarea>"
                   "</div></section>");
-    send_all(fd, "<section><h2>Join mesh</h2>"
+    send_all(conn->fd, "<section><h2>Join mesh</h2>"
                   "<p>Paste a join config from another node to connect over LAN.</p>"
                   "<textarea id=\"join-input\" rows=\"7\"></textarea>"
                   "<div class=\"actions\"><button id=\"join-mesh\">Join mesh</button>"
                   "<span id=\"join-status\"></span></div></section>");
-    send_all(fd, "<section><h2>LAN peers</h2>"
+    send_all(conn->fd, "<section><h2>LAN peers</h2>"
                   "<table id=\"wg-peers\">"
                   "<thead><tr>"
                   "<th>Endpoint</th><th>Web port</th><th>Status</th><th>Actions</th>"
                   "</tr></thead><tbody></tbody></table></section>");
-    send_all(fd, "<div class=\"actions\">"
+    send_all(conn->fd, "<div class=\"actions\">"
                   "<button id=\"save-config\">Save changes</button>"
                   "<span id=\"save-status\"></span>"
                   "</div>");
-    send_all(fd,
+    send_all(conn->fd,
              "<script>"
              "const qrcodegen=function(){function e(e,t){this.modules=null,this.moduleCount=0,this.errorCorrectLevel=e,this.typeNumber=t}function t(e){this.mode=a.MODE_8BIT_BYTE,this.data=e,this.parsed=[];for(let t=0;t<e.length;t++){const r=e.charCodeAt(t);r<128?this.parsed.push(r):r<2048?(this.parsed.push(192|r>>6),this.parsed.push(128|63&r)):r<65536?(this.parsed.push(224|r>>12),this.parsed.push(128|r>>6&63),this.parsed.push(128|63&r)):(this.parsed.push(240|r>>18),this.parsed.push(128|r>>12&63),this.parsed.push(128|r>>6&63),this.parsed.push(128|63&r))}}const r={};r.QrCode=e,r.QrSegment=t;const a={};a.PAD0=236,a.PAD1=17,a.Ecc={LOW:1,MEDIUM:0,QUARTILE:3,HIGH:2},a.MODE_8BIT_BYTE=4,a.getBCHTypeInfo=function(e){let t=e<<10;for(;a.getBCHDigit(t)-a.getBCHDigit(1335)>=0;)t^=1335<<a.getBCHDigit(t)-a.getBCHDigit(1335);return(e<<10|t)^21522},a.getBCHTypeNumber=function(e){let t=e<<12;for(;a.getBCHDigit(t)-a.getBCHDigit(7973)>=0;)t^=7973<<a.getBCHDigit(t)-a.getBCHDigit(7973);return e<<12|t},a.getBCHDigit=function(e){let t=0;for(;e!=0;)t++,e>>=1;return t},a.getPatternPosition=function(e){return a.PATTERN_POSITION_TABLE[e-1]},a.getMask=function(e,t,r){switch(e){case 0:return(t+r)%2==0;case 1:return t%2==0;case 2:return r%3==0;case 3:return(t+r)%3==0;case 4:return(Math.floor(t/2)+Math.floor(r/3))%2==0;case 5:return t*r%2+t*r%3==0;case 6:return(t*r%2+t*r%3)%2==0;case 7:return(t*r%3+(t+r)%2)%2==0;default:throw new Error('bad maskPattern:'+e)}},a.getErrorCorrectPolynomial=function(e){let t=new i([1],0);for(let r=0;r<e;r++)t=t.multiply(new i([1,a.gexp(r)],0));return t},a.getLengthInBits=function(e,t){if(1<=t&&t<10)return 8;else if(t<27)return 16;else if(t<41)return 16;throw new Error('type:'+t)},a.getLostPoint=function(e){const t=e.moduleCount;let r=0;for(let a=0;a<t;a++)for(let i=0;i<t;i++){let n=0;const o=e.isDark(a,i);for(let e=-1;e<=1;e++)if(!(a+e<0||t<=a+e))for(let t=-1;t<=1;t++)if(!(i+t<0||t<=i+t)&&!(0==e&&0==t)&&o==e.isDark(a+e,i+t))n++;n>5&&(r+=3+n-5)}for(let a=0;a<t-1;a++)for(let i=0;i<t-1;i++){let n=0;e.isDark(a,i)&&n++,e.isDark(a+1,i)&&n++,e.isDark(a,i+1)&&n++,e.isDark(a+1,i+1)&&n++;(0==n||4==n)&&(r+=3)}for(let a=0;a<t;a++)for(let i=0;i<t-6;i++)e.isDark(a,i)&&!e.isDark(a,i+1)&&e.isDark(a,i+2)&&e.isDark(a,i+3)&&e.isDark(a,i+4)&&!e.isDark(a,i+5)&&e.isDark(a,i+6)&&(r+=40);for(let a=0;a<t;a++)for(let i=0;i<t-6;i++)e.isDark(i,a)&&!e.isDark(i+1,a)&&e.isDark(i+2,a)&&e.isDark(i+3,a)&&e.isDark(i+4,a)&&!e.isDark(i+5,a)&&e.isDark(i+6,a)&&(r+=40);let a=0;for(let r=0;r<t;r++)for(let i=0;i<t;i++)e.isDark(r,i)&&a++;return r+=10*Math.abs(100*a/t/t-50)/5},a.getRSBlocks=function(e,t){const r=a.RS_BLOCK_TABLE[4*(e-1)+t];if(void 0==r)throw new Error('bad rs block @ typeNumber:'+e+'/errorCorrectLevel:'+t);const i=r.length/3,n=[];for(let o=0;o<i;o++)for(let i=r[3*o+0],s=r[3*o+1],l=r[3*o+2],u=0;u<i;u++)n.push(new s(s,l));return n};const i=function(e,t){if(void 0==e.length)throw new Error(e.length+'/'+t);for(let t=0;t<e.length&&0==e[t];)t++;this.num=new Array(e.length-t+t);for(let r=0;r<e.length-t;r++)this.num[r]=e[r+t];this.shift=t};i.prototype={get:function(e){return this.num[e]},getLength:function(){return this.num.length},multiply:function(e){const t=new Array(this.getLength()+e.getLength()-1);for(let e=0;e<t.length;e++)t[e]=0;for(let r=0;r<this.getLength();r++)for(let a=0;a<e.getLength();a++)t[r+a]^=a.gexp(a.glog(this.get(r))+a.glog(e.get(a)));return new i(t,0)},mod:function(e){if(this.getLength()-e.getLength()<0)return this;const t=a.glog(this.get(0))-a.glog(e.get(0)),r=new Array(this.getLength());for(let e=0;e<this.getLength();e++)r[e]=this.get(e);for(let r=0;r<e.getLength();r++)r[r]^=a.gexp(a.glog(e.get(r))+t);return new i(r,0).mod(e)}};a.glog=function(e){if(e<1)throw new Error('glog('+e+')');return a.LOG_TABLE[e]};a.gexp=function(e){for(;e<0;)e+=255;for(;e>=256;)e-=255;return a.EXP_TABLE[e]};a.EXP_TABLE=new Array(256);a.LOG_TABLE=new Array(256);for(let e=0;e<8;e++)a.EXP_TABLE[e]=1<<e;for(let e=8;e<256;e++)a.EXP_TABLE[e]=a.EXP_TABLE[e-4]^a.EXP_TABLE[e-5]^a.EXP_TABLE[e-6]^a.EXP_TABLE[e-8];for(let e=0;e<255;e++)a.LOG_TABLE[a.EXP_TABLE[e]]=e;a.RS_BLOCK_TABLE=[1,26,19,1,26,16,1,26,13,1,26,9,1,44,34,1,44,28,1,44,22,1,44,16,1,70,55,1,70,44,2,35,17,2,35,13,1,100,80,2,50,32,2,50,24,4,25,9,1,134,108,2,67,43,2,33,15,2,33,11,2,86,68,4,43,27,4,43,19,4,43,15,2,98,78,4,49,31,2,32,14,4,39,13,4,121,97,2,60,38,4,40,18,2,30,14,4,40,18,4,36,16,2,146,116,4,58,36,4,36,16,4,46,20,4,40,18,2,86,68,4,69,43,6,43,19,2,44,18,2,100,80,4,50,32,6,50,24,4,25,9,2,134,108,4,67,43,6,33,15,2,33,11,4,146,116,6,58,36,2,36,16,4,46,20,6,40,18,4,50,32,4,50,24,2,25,9,4,121,97,4,60,38,6,40,18,2,30,14,2,146,116,6,58,36,4,36,16,6,46,20,4,40,18,4,61,47,4,47,27,6,38,22,2,29,14,4,58,40,2,47,26,4,37,22,4,29,14,4,147,116,6,58,36,2,36,16,7,46,20,6,40,18,4,77,59,8,47,27,8,38,22,4,29,14,5,65,52,10,39,24,8,37,22,8,29,14,6,139,106,6,69,43,4,43,19,4,33,11,7,79,61,6,47,27,8,38,22,2,31,14,5,73,55,6,46,20,10,39,24,4,37,22,8,29,14,13,145,112,8,58,36,4,36,16,11,46,20,6,40,18,5,56,44,10,47,27,10,38,22,4,29,14,12,92,68,12,58,36,4,36,16,11,46,20,4,40,18,7,42,32,14,47,27,14,38,22,6,29,14,4,133,104,16,58,36,2,36,16,11,46,20,4,40,18,9,74,56,16,47,27,16,38,22,4,29,14,2,131,104,8,59,37,6,37,16,11,46,20,6,40,18,2,93,69,17,47,27,22,45,20,13,28,10,4,107,81,4,65,40,14,39,18,16,49,24,4,36,16,2,116,92,6,58,36,14,37,16,16,46,20,6,40,18,4,121,97,14,47,27,16,38,22,4,29,14,6,114,88,12,60,37,6,41,17,10,46,20,6,40,18,7,122,98,14,48,27,11,39,22,7,30,14,4,117,91,10,61,37,16,38,17,16,46,20,6,40,18,7,126,100,12,47,27,16,38,22,4,29,14,6,100,80,10,54,27,14,41,18,2,32,14,9,143,108,14,61,37,10,39,18,12,46,20,6,40,18,7,110,84,12,48,27,18,44,20,8,31,14,5,127,98,14,62,37,10,40,18,16,46,20,6,40,18,8,139,105,14,47,27,22,45,20,8,30,14,8,107,81,12,51,27,12,41,18,12,45,20,2,32,14,10,97,74,14,48,27,18,45,20,8,31,14,3,120,90,14,52,27,20,38,18,10,46,20,6,40,18,7,142,107,10,53,27,18,43,20,10,31,14,4,88,67,20,51,27,20,41,18,4,47,20,6,40,18,2,116,86,10,46,27,28,45,20,14,31,14,4,82,62,14,48,27,28,44,20,2,32,14,4,137,104,14,53,27,18,42,20,4,33,14,13,115,87,8,40,27,12,31,20,8,41,14,4,80,58,14,50,27,20,47,20,4,32,14,5,118,89,16,55,27,20,45,20,8,33,14,5,80,60,12,46,27,24,42,20,8,32,14,11,115,87,12,45,27,22,40,20,4,33,14,5,102,78,12,48,27,28,44,20,4,31,14,8,132,96,14,54,27,32,43,20,4,32,14,5,94,70,20,51,27,28,45,20,4,31,14,10,117,87,14,45,27,24,42,20,10,32,14,10,88,64,14,50,27,24,39,20,8,32,14,4,130,98,18,54,27,16,43,20,4,32,14,14,115,85,16,46,27,24,41,20,6,32,14,5,94,70,26,50,27,16,40,20,6,32,14,8,126,96,18,53,27,16,43,20,10,32,14,10,91,67,26,50,27,18,40,20,8,32,14,8,127,96,22,53,27,22,43,20,12,32,14,5,100,75,24,49,27,30,40,20,8,32,14,11,112,84,24,51,27,18,42,20,4,32,14,5,103,77,28,49,27,28,40,20,12,32,14,5,117,87,26,52,27,22,42,20,4,32,14,11,112,84,26,50,27,30,41,20,8,32,14,4,119,89,26,49,27,24,41,20,8,32,14,6,106,80,24,51,27,28,42,20,12,32,14,4,113,85,28,53,27,22,43,20,4,32,14,5,129,96,28,52,27,32,42,20,8,32,14,4,120,90,28,50,27,24,42,20,8,32,14,12,119,87,28,54,27,24,43,20,8,32,14,4,113,85,30,53,27,24,43,20,12,32,14,7,110,86,28,54,27,32,43,20,12,32,14,12,119,87,28,50,27,24,43,20,12,32,14];a.PATTERN_POSITION_TABLE=[[],[6,18],[6,22],[6,26],[6,30],[6,34],[6,22,38],[6,24,42],[6,26,46],[6,28,50],[6,30,54],[6,32,58],[6,34,62],[6,26,46,66],[6,26,48,70],[6,26,50,74],[6,30,54,78],[6,30,56,82],[6,30,58,86],[6,34,62,90],[6,28,50,72,94],[6,26,50,74,98],[6,30,54,78,102],[6,28,54,80,106],[6,32,58,84,110],[6,30,58,86,114],[6,34,62,90,118],[6,26,50,74,98,122],[6,30,54,78,102,126],[6,26,52,78,104,130],[6,30,56,82,108,134],[6,34,60,86,112,138],[6,30,58,86,114,142],[6,34,62,90,118,146],[6,30,54,78,102,126,150],[6,24,50,76,102,128,154],[6,28,54,80,106,132,158],[6,32,58,84,110,136,162],[6,26,54,82,110,138,166],[6,30,58,86,114,142,170]];e.prototype={addData:function(e){this.dataList||(this.dataList=[]);this.dataList.push(new t(e))},isDark:function(e,t){if(e<0||this.moduleCount<=e||t<0||this.moduleCount<=t)throw new Error(e+','+t);return this.modules[e][t]},getModuleCount:function(){return this.moduleCount},make:function(){if(this.typeNumber<1){let e=1;for(;e<40;e++){const t=a.getRSBlocks(e,this.errorCorrectLevel),r=new n;let i=0;for(let e=0;e<t.length;e++)i+=t[e].dataCount;for(let e=0;e<this.dataList.length;e++){const t=this.dataList[e];r.put(t.mode,4),r.put(t.parsed.length,a.getLengthInBits(t.mode,e)),t.write(r)}if(r.getLengthInBits()<=8*i)break}this.typeNumber=e}this.makeImpl(!1,this.getBestMaskPattern())},makeImpl:function(e,t){this.moduleCount=4*this.typeNumber+17,this.modules=new Array(this.moduleCount);for(let e=0;e<this.moduleCount;e++){this.modules[e]=new Array(this.moduleCount);for(let t=0;t<this.moduleCount;t++)this.modules[e][t]=null}this.setupPositionProbePattern(0,0),this.setupPositionProbePattern(this.moduleCount-7,0),this.setupPositionProbePattern(0,this.moduleCount-7),this.setupPositionAdjustPattern(),this.setupTimingPattern(),this.setupTypeInfo(e,t),this.typeNumber>=7&&this.setupTypeNumber(e);const r=this.createData(this.typeNumber,this.errorCorrectLevel);this.mapData(r,t)},setupPositionProbePattern:function(e,t){for(let r=-1;r<=7;r++)if(!(e+r<=-1||this.moduleCount<=e+r))for(let a=-1;a<=7;a++)t+a<=-1||this.moduleCount<=t+a||(r>=0&&r<=6&&(0==a||6==a)||a>=0&&a<=6&&(0==r||6==r)||r>=2&&r<=4&&a>=2&&a<=4?this.modules[e+r][t+a]=!0:this.modules[e+r][t+a]=!1)},getBestMaskPattern:function(){let e=0,t=0;for(let r=0;r<8;r++){this.makeImpl(!0,r);const a=a.getLostPoint(this);(0==r||e>a)&&(e=a,t=r)}return t},createData:function(e,t){const r=a.getRSBlocks(e,t),i=new n;for(let e=0;e<this.dataList.length;e++){const t=this.dataList[e];i.put(t.mode,4),i.put(t.parsed.length,a.getLengthInBits(t.mode,e)),t.write(i)}let s=0;for(let e=0;e<r.length;e++)s+=r[e].dataCount;if(i.getLengthInBits()>8*s)throw new Error('code length overflow. ('+i.getLengthInBits()+'>'+8*s+')');for(i.getLengthInBits()+4<=8*s&&i.put(0,4);i.getLengthInBits()%8!=0;)i.putBit(!1);for(;;){if(i.getLengthInBits()>=8*s)break;i.put(a.PAD0,8);if(i.getLengthInBits()>=8*s)break;i.put(a.PAD1,8)}return a.createBytes(i,r)},createBytes:function(e,t){let r=0,a=0,i=0;const n=new Array(t.length),o=new Array(t.length);for(let s=0;s<t.length;s++){const l=t[s].dataCount,u=t[s].totalCount-l;a=Math.max(a,l),i=Math.max(i,u),n[s]=new Array(l);for(let t=0;t<n[s].length;t++)n[s][t]=255&e.buffer[t+r];r+=l;const c=a.getErrorCorrectPolynomial(u),d=new i(n[s],c.getLength()-1).mod(c);o[s]=new Array(c.getLength()-1);for(let e=0;e<o[s].length;e++){const t=e+d.getLength()-o[s].length;o[s][e]=t>=0?d.get(t):0}}let s=0;const l=[];for(let e=0;e<a;e++)for(let t=0;t<n.length;t++)e<n[t].length&&(l[s++]=n[t][e]);for(let e=0;e<i;e++)for(let t=0;t<o.length;t++)e<o[t].length&&(l[s++]=o[t][e]);return l},setupTimingPattern:function(){for(let e=8;e<this.moduleCount-8;e++)null==this.modules[e][6]&&(this.modules[e][6]=e%2==0);for(let e=8;e<this.moduleCount-8;e++)null==this.modules[6][e]&&(this.modules[6][e]=e%2==0)},setupPositionAdjustPattern:function(){const e=a.getPatternPosition(this.typeNumber);for(let t=0;t<e.length;t++)for(let r=0;r<e.length;r++){const a=e[t],i=e[r];null==this.modules[a][i]&&this.setupPositionAdjustPatternAt(a,i)}},setupPositionAdjustPatternAt:function(e,t){for(let r=-2;r<=2;r++)for(let a=-2;a<=2;a++)this.modules[e+r][t+a]=r==-2||r==2||a==-2||a==2||0==r&&0==a},setupTypeNumber:function(e){const t=a.getBCHTypeNumber(this.typeNumber);for(let r=0;r<18;r++){const a=!e&&1==(t>>r&1);this.modules[Math.floor(r/3)][r%3+this.moduleCount-8-3]=a}for(let r=0;r<18;r++){const a=!e&&1==(t>>r&1);this.modules[r%3+this.moduleCount-8-3][Math.floor(r/3)]=a}},setupTypeInfo:function(e,t){const r=a.getBCHTypeInfo(this.errorCorrectLevel<<3|t);for(let a=0;a<15;a++){const t=!e&&1==(r>>a&1);a<6?this.modules[a][8]=t:a<8?this.modules[a+1][8]=t:this.modules[this.moduleCount-15+a][8]=t}for(let a=0;a<15;a++){const t=!e&&1==(r>>a&1);a<8?this.modules[8][this.moduleCount-a-1]=t:a<9?this.modules[8][15-a-1+1]=t:this.modules[8][15-a-1]=t}this.modules[this.moduleCount-8][8]=!e},mapData:function(e,t){let r=this.moduleCount-1,a=this.moduleCount-1,i=-1;for(let n=0;n<this.moduleCount-1;n++){for(let o=0;o<this.moduleCount;o++){const s=this.moduleCount-1-o;for(let o=0;o<2;o++)if(null==this.modules[r][s-o]){let l=!1;a<e.length&&(l=1==(e[a]>>>i&1));const u=a.getMask(t,r,s-o);u&&(l=!l),this.modules[r][s-o]=l,i--;if(-1==i){a++,i=7}}}r+=i==1?-1:1,i=-i}}};const n=function(){this.buffer=[];this.length=0};n.prototype={get:function(e){const t=Math.floor(e/8);return 1==(this.buffer[t]>>>7-e%8&1)},put:function(e,t){for(let r=0;r<t;r++)this.putBit(1==(e>>>t-r-1&1))},getLengthInBits:function(){return this.length},putBit:function(e){const t=Math.floor(this.length/8);this.buffer.length<=t&&this.buffer.push(0),e&&(this.buffer[t]|=128>>>this.length%8),this.length++}};t.prototype={write:function(e){for(let t=0;t<this.parsed.length;t++)e.put(this.parsed[t],8)}};return r}();"
              "const wgPeers = [];"
@@ -679,7 +631,7 @@ static void respond_mesh_ui(int fd) {
              "});"
              "loadConfig();"
              "</script>");
-    send_html_footer(fd);
+    send_html_footer(conn->fd);
 }
 
 static int mesh_mount_points_equal(const junknas_config_t *config, cJSON *mounts) {
@@ -763,10 +715,11 @@ static int merge_mesh_payload(junknas_config_t *config, const char *payload) {
     if (peers_changed) {
         config->wg_peers_updated_at = (uint64_t)now;
     }
+    junknas_config_unlock(config);
     if (peers_changed || mounts_changed) {
-        (void)junknas_config_save(config, config->config_file_path);
+        junknas_config_publish(config);
+        junknas_config_mark_dirty(config);
     }
-    junknas_config_unlock(config);
 
     cJSON_Delete(root);
     return (peers_changed || mounts_changed) ? 1 : 0;
@@ -859,35 +812,36 @@ static int update_mesh_config(junknas_config_t *config, const char *payload) {
          strcmp(node_state->valuestring, NODE_STATE_END) == 0)) {
         snprintf(config->node_state, sizeof(config->node_state), "%s", node_state->valuestring);
     }
-    (void)junknas_config_save(config, config->config_file_path);
     junknas_config_unlock(config);
+    junknas_config_publish(config);
+    junknas_config_mark_dirty(config);
 
     cJSON_Delete(root);
     return 0;
 }
 
-static int respond_mesh_bootstrap(int fd, junknas_config_t *config) {
-    if (!config) return -1;
-    if (strcmp(config->node_state, NODE_STATE_END) == 0) {
-        send_status(fd, 403, "Forbidden");
+static int respond_mesh_bootstrap(web_conn_t *conn) {
+    if (!conn->config) return -1;
+    if (strcmp(conn->config->node_state, NODE_STATE_END) == 0) {
+        send_status(conn, 403, "Forbidden");
         return -1;
     }
     char server_endpoint[MAX_ENDPOINT_LEN];
     uint16_t server_web_port = DEFAULT_WEB_PORT;
 
-    junknas_config_lock(config);
-    snprintf(server_endpoint, sizeof(server_endpoint), "%s", config->wg.endpoint);
-    server_web_port = config->web_port;
-    junknas_config_unlock(config);
+    junknas_config_lock(conn->config);
+    snprintf(server_endpoint, sizeof(server_endpoint), "%s", conn->config->wg.endpoint);
+    server_web_port = conn->config->web_port;
+    junknas_config_unlock(conn->config);
 
     if (server_endpoint[0] == '\0') {
-        web_log_verbose(config, "mesh: issuing join config without server endpoint");
+        web_log_verbose(conn->config, "mesh: issuing join config without server endpoint");
     }
-    web_log_verbose(config, "mesh: issued join config for LAN peer");
+    web_log_verbose(conn->config, "mesh: issued join config for LAN peer");
 
     cJSON *root = cJSON_CreateObject();
     if (!root) {
-        send_status(fd, 500, "Error");
+        send_status(conn, 500, "Error");
         return -1;
     }
     cJSON_AddStringToObject(root, "server_endpoint", server_endpoint);
@@ -896,19 +850,19 @@ static int respond_mesh_bootstrap(int fd, junknas_config_t *config) {
     char *printed = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
     if (!printed) {
-        send_status(fd, 500, "Error");
+        send_status(conn, 500, "Error");
         return -1;
     }
-    send_json(fd, 200, printed);
+    send_json(conn, 200, printed);
     free(printed);
     return 0;
 }
 
-static int respond_mesh_alternate(int fd, junknas_config_t *config, const char *payload) {
-    if (!config || !payload) return -1;
+static int respond_mesh_alternate(web_conn_t *conn, const char *payload) {
+    if (!conn->config || !payload) return -1;
     cJSON *root = cJSON_Parse(payload);
     if (!root) {
-        send_status(fd, 400, "Bad Request");
+        send_status(conn, 400, "Bad Request");
         return -1;
     }
 
@@ -916,7 +870,7 @@ static int respond_mesh_alternate(int fd, junknas_config_t *config, const char *
     cJSON *endpoint = cJSON_GetObjectItemCaseSensitive(root, "endpoint");
     if (!cJSON_IsString(endpoint) || !endpoint->valuestring) {
         cJSON_Delete(root);
-        send_status(fd, 400, "Bad Request");
+        send_status(conn, 400, "Bad Request");
         return -1;
     }
     snprintf(peer.endpoint, sizeof(peer.endpoint), "%s", endpoint->valuestring);
@@ -926,37 +880,38 @@ static int respond_mesh_alternate(int fd, junknas_config_t *config, const char *
     }
 
     time_t now = time(NULL);
-    junknas_config_lock(config);
-    int rc = update_wg_peer_by_ip(config, &peer);
+    junknas_config_lock(conn->config);
+    int rc = update_wg_peer_by_ip(conn->config, &peer);
     if (rc < 0) {
-        junknas_config_unlock(config);
+        junknas_config_unlock(conn->config);
         cJSON_Delete(root);
-        send_status(fd, 400, "Bad Request");
+        send_status(conn, 400, "Bad Request");
         return -1;
     }
-    config->wg_peers_updated_at = (uint64_t)now;
-    (void)junknas_config_save(config, config->config_file_path);
-    junknas_config_unlock(config);
+    conn->config->wg_peers_updated_at = (uint64_t)now;
+    junknas_config_unlock(conn->config);
+    junknas_config_publish(conn->config);
+    junknas_config_mark_dirty(conn->config);
 
-    web_log_verbose(config, "mesh: updated alternate peer %s", peer.endpoint);
+    web_log_verbose(conn->config, "mesh: updated alternate peer %s", peer.endpoint);
 
     cJSON_Delete(root);
-    send_json(fd, 200, "{\"status\":\"ok\"}");
+    send_json(conn, 200, "{\"status\":\"ok\"}");
     return 0;
 }
 
-static int respond_mesh_join(int fd, junknas_config_t *config, const char *payload) {
-    if (!config || !payload) return -1;
+static int respond_mesh_join(web_conn_t *conn, const char *payload) {
+    if (!conn->config || !payload) return -1;
     cJSON *root = cJSON_Parse(payload);
     if (!root) {
-        send_status(fd, 400, "Bad Request");
+        send_status(conn, 400, "Bad Request");
         return -1;
     }
 
     cJSON *join = cJSON_GetObjectItemCaseSensitive(root, "join_config");
     if (!cJSON_IsObject(join)) {
         cJSON_Delete(root);
-        send_status(fd, 400, "Bad Request");
+        send_status(conn, 400, "Bad Request");
         return -1;
     }
 
@@ -968,7 +923,7 @@ static int respond_mesh_join(int fd, junknas_config_t *config, const char *paylo
         endpoint_value = server_endpoint->valuestring;
     }
     if (endpoint_value[0] == '\0') {
-        web_log_verbose(config, "mesh: join config missing server endpoint");
+        web_log_verbose(conn->config, "mesh: join config missing server endpoint");
     }
 
     uint16_t web_port = DEFAULT_WEB_PORT;
@@ -981,36 +936,37 @@ static int respond_mesh_join(int fd, junknas_config_t *config, const char *paylo
     if (cJSON_IsString(peer_endpoint_json) && peer_endpoint_json->valuestring) {
         peer_endpoint = peer_endpoint_json->valuestring;
     }
-    web_log_verbose(config,
+    web_log_verbose(conn->config,
                     "mesh: join request parsed (endpoint=%s web_port=%u)",
                     endpoint_value[0] ? endpoint_value : "(none)",
                     web_port);
 
     time_t now = time(NULL);
-    junknas_config_lock(config);
+    junknas_config_lock(conn->config);
     if (peer_endpoint[0] != '\0') {
-        snprintf(config->wg.endpoint, sizeof(config->wg.endpoint), "%s", peer_endpoint);
+        snprintf(conn->config->wg.endpoint, sizeof(conn->config->wg.endpoint), "%s", peer_endpoint);
     }
 
     junknas_wg_peer_t server_peer = {0};
     snprintf(server_peer.endpoint, sizeof(server_peer.endpoint), "%s", endpoint_value);
     server_peer.web_port = web_port;
-    int upserted = junknas_config_upsert_wg_peer(config, &server_peer);
+    int upserted = junknas_config_upsert_wg_peer(conn->config, &server_peer);
     if (upserted < 0) {
-        junknas_config_unlock(config);
+        junknas_config_unlock(conn->config);
         cJSON_Delete(root);
-        send_status(fd, 400, "Bad Request");
+        send_status(conn, 400, "Bad Request");
         return -1;
     }
-    config->wg_peers_updated_at = (uint64_t)now;
-    (void)junknas_config_save(config, config->config_file_path);
-    junknas_config_unlock(config);
+    conn->config->wg_peers_updated_at = (uint64_t)now;
+    junknas_config_unlock(conn->config);
+    junknas_config_publish(conn->config);
+    junknas_config_mark_dirty(conn->config);
 
-    web_log_verbose(config, "mesh: join config saved (upserted=%d)", upserted);
-    web_log_verbose(config, "mesh: joined via %s", server_peer.endpoint);
+    web_log_verbose(conn->config, "mesh: join config saved (upserted=%d)", upserted);
+    web_log_verbose(conn->config, "mesh: joined via %s", server_peer.endpoint);
 
     cJSON_Delete(root);
-    send_json(fd, 200, "{\"status\":\"ok\"}");
+    send_json(conn, 200, "{\"status\":\"ok\"}");
     return 0;
 }
 
@@ -1022,11 +978,11 @@ static int sync_mesh_with_peer(junknas_config_t *config, const char *endpoint, c
     size_t payload_len = strlen(payload);
     char request[512];
     snprintf(request, sizeof(request),
-             "POST /mesh/peers HTTP/1.1\r\nHost: %s\r\nConnection: close\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n\r\n",
+             "POST /mesh/peers HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n\r\n",
              host, payload_len);
 
     int status = 0;
-    char *body = http_request_body(host, port, request, payload, payload_len, &status);
+    char *body = junknas_http_request_body(config, host, port, request, payload, payload_len, &status);
     if (!body) return -1;
 
     if (status >= 200 && status < 300) {
@@ -1041,100 +997,130 @@ static int sync_mesh_with_peer(junknas_config_t *config, const char *endpoint, c
     return -1;
 }
 
-static void respond_mount_listing(int fd, junknas_config_t *config, const char *rel_path) {
+static void respond_mount_listing(web_conn_t *conn, const char *rel_path) {
     char full_path[MAX_PATH_LEN];
     if (rel_path && rel_path[0] != '\0') {
-        snprintf(full_path, sizeof(full_path), "%s/%s", config->mount_point, rel_path);
+        snprintf(full_path, sizeof(full_path), "%s/%s", conn->config->mount_point, rel_path);
     } else {
-        snprintf(full_path, sizeof(full_path), "%s", config->mount_point);
+        snprintf(full_path, sizeof(full_path), "%s", conn->config->mount_point);
     }
 
     DIR *dir = opendir(full_path);
     if (!dir) {
-        send_status(fd, 404, "Not Found");
+        send_status(conn, 404, "Not Found");
         return;
     }
 
-    send_html_header(fd, "junkNAS fileshare");
-    send_all(fd, "<h1>junkNAS fileshare</h1>");
-    send_all(fd, "<p><a href=\"/mesh/ui\">Mesh settings</a></p>");
-    send_all(fd, "<p>Mount point: ");
-    send_all(fd, config->mount_point);
-    send_all(fd, "</p>");
+    send_html_header(conn, "junkNAS fileshare");
+    send_all(conn->fd, "<h1>junkNAS fileshare</h1>");
+    send_all(conn->fd, "<p><a href=\"/mesh/ui\">Mesh settings</a></p>");
+    send_all(conn->fd, "<p>Mount point: ");
+    send_all(conn->fd, conn->config->mount_point);
+    send_all(conn->fd, "</p>");
 
-    if (config->data_mount_point_count > 0) {
+    if (conn->config->data_mount_point_count > 0) {
         char stamp[64];
         snprintf(stamp, sizeof(stamp), "%llu",
-                 (unsigned long long)config->data_mount_points_updated_at);
-        send_all(fd, "<h2>Mesh mount points</h2><ul>");
-        for (int i = 0; i < config->data_mount_point_count; i++) {
-            send_all(fd, "<li>");
-            send_all(fd, config->data_mount_points[i]);
-            send_all(fd, "</li>");
+                 (unsigned long long)conn->config->data_mount_points_updated_at);
+        send_all(conn->fd, "<h2>Mesh mount points</h2><ul>");
+        for (int i = 0; i < conn->config->data_mount_point_count; i++) {
+            send_all(conn->fd, "<li>");
+            send_all(conn->fd, conn->config->data_mount_points[i]);
+            send_all(conn->fd, "</li>");
         }
-        send_all(fd, "</ul><p>Updated at: ");
-        send_all(fd, stamp);
-        send_all(fd, "</p>");
+        send_all(conn->fd, "</ul><p>Updated at: ");
+        send_all(conn->fd, stamp);
+        send_all(conn->fd, "</p>");
     }
 
-    send_all(fd, "<h2>Directory listing</h2><ul>");
+    send_all(conn->fd, "<h2>Directory listing</h2><ul>");
     struct dirent *ent;
     while ((ent = readdir(dir)) != NULL) {
         if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) continue;
-        send_all(fd, "<li>");
+        send_all(conn->fd, "<li>");
         if (ent->d_type == DT_DIR) {
-            send_all(fd, "<strong>");
-            send_all(fd, ent->d_name);
-            send_all(fd, "/</strong>");
-            send_all(fd, " (<a href=\"/browse/");
+            send_all(conn->fd, "<strong>");
+            send_all(conn->fd, ent->d_name);
+            send_all(conn->fd, "/</strong>");
+            send_all(conn->fd, " (<a href=\"/browse/");
             if (rel_path && rel_path[0] != '\0') {
-                send_all(fd, rel_path);
-                send_all(fd, "/");
+                send_all(conn->fd, rel_path);
+                send_all(conn->fd, "/");
             }
-            send_all(fd, ent->d_name);
-            send_all(fd, "\">browse</a>)");
+            send_all(conn->fd, ent->d_name);
+            send_all(conn->fd, "\">browse</a>)");
         } else {
-            send_all(fd, "<a href=\"/files/");
+            send_all(conn->fd, "<a href=\"/files/");
             if (rel_path && rel_path[0] != '\0') {
-                send_all(fd, rel_path);
-                send_all(fd, "/");
+                send_all(conn->fd, rel_path);
+                send_all(conn->fd, "/");
             }
-            send_all(fd, ent->d_name);
-            send_all(fd, "\">");
-            send_all(fd, ent->d_name);
-            send_all(fd, "</a>");
+            send_all(conn->fd, ent->d_name);
+            send_all(conn->fd, "\">");
+            send_all(conn->fd, ent->d_name);
+            send_all(conn->fd, "</a>");
         }
-        send_all(fd, "</li>");
+        send_all(conn->fd, "</li>");
     }
     closedir(dir);
-    send_all(fd, "</ul>");
-    send_html_footer(fd);
+    send_all(conn->fd, "</ul>");
+    send_html_footer(conn->fd);
 }
 
-static void respond_file(int fd, const char *path) {
+/* Stream up to want bytes of in_fd to sock, preferring sendfile() so
+ * chunk payloads never round-trip through userspace. Falls back to a
+ * read/send loop for fds sendfile cannot source from. Returns the
+ * number of bytes actually streamed. */
+static size_t send_file_contents(int sock, int in_fd, size_t want) {
+    size_t sent = 0;
+    int use_sendfile = 1;
+    char buf[8192];
+    while (sent < want) {
+        size_t ask = want - sent;
+        if (use_sendfile) {
+            if (ask > WEB_SENDFILE_MAX) ask = WEB_SENDFILE_MAX;
+            ssize_t n = sendfile(sock, in_fd, NULL, ask);
+            if (n > 0) {
+                sent += (size_t)n;
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                use_sendfile = 0;
+                continue;
+            }
+            break;
+        }
+        if (ask > sizeof(buf)) ask = sizeof(buf);
+        ssize_t n = read(in_fd, buf, ask);
+        if (n <= 0) break;
+        if (send(sock, buf, (size_t)n, 0) < 0) break;
+        sent += (size_t)n;
+    }
+    return sent;
+}
+
+static void respond_file(web_conn_t *conn, const char *path) {
     int in = open(path, O_RDONLY);
     if (in < 0) {
-        send_status(fd, 404, "Not Found");
+        send_status(conn, 404, "Not Found");
         return;
     }
 
     struct stat st;
     if (fstat(in, &st) != 0) {
         close(in);
-        send_status(fd, 500, "Error");
+        send_status(conn, 500, "Error");
         return;
     }
 
     char header[256];
     snprintf(header, sizeof(header),
-             "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
-             (size_t)st.st_size);
-    send_all(fd, header);
-
-    char buf[4096];
-    ssize_t n;
-    while ((n = read(in, buf, sizeof(buf))) > 0) {
-        send(fd, buf, (size_t)n, 0);
+             "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\nConnection: %s\r\n\r\n",
+             (size_t)st.st_size, conn_header(conn));
+    send_all(conn->fd, header);
+    if (send_file_contents(conn->fd, in, (size_t)st.st_size) != (size_t)st.st_size) {
+        conn->keep_alive = 0;          /* short stream broke the framing */
     }
     close(in);
 }
@@ -1159,85 +1145,333 @@ static void ensure_parent_dir(const char *path) {
     mkdir(tmp, 0755);
 }
 
+/* ------------------------- Verified chunk ingest ------------------------
+ *
+ * Uploaded chunks are streamed into an unlinked O_TMPFILE in the store
+ * directory while being hashed, then linked into place only if the
+ * digest matches the requested address. A torn or corrupt upload can
+ * therefore never surface under a content address, and a crash leaves
+ * no partial files behind. Filesystems without O_TMPFILE fall back to
+ * a visible temp name renamed into place.
+ */
+
+typedef struct {
+    int fd;
+    int anon;                          /* O_TMPFILE; link into place */
+    char tmp_path[MAX_PATH_LEN];       /* fallback path, empty when anon */
+    char final_path[MAX_PATH_LEN];
+    sha256_ctx hash;
+} web_ingest_t;
+
+static int web_ingest_begin(web_ingest_t *ing, const char *chunk_path) {
+    memset(ing, 0, sizeof(*ing));
+    ing->fd = -1;
+    if (snprintf(ing->final_path, sizeof(ing->final_path), "%s",
+                 chunk_path) >= (int)sizeof(ing->final_path)) {
+        return -1;
+    }
+    ensure_parent_dir(ing->final_path);
+
+    char dir[MAX_PATH_LEN];
+    snprintf(dir, sizeof(dir), "%s", chunk_path);
+    char *slash = strrchr(dir, '/');
+    if (slash) *slash = '\0';
+
+    ing->fd = open(slash ? dir : ".", O_TMPFILE | O_RDWR, 0644);
+    if (ing->fd >= 0) {
+        ing->anon = 1;
+    } else {
+        if (snprintf(ing->tmp_path, sizeof(ing->tmp_path), "%s.ingest.%d",
+                     chunk_path, getpid()) >= (int)sizeof(ing->tmp_path)) {
+            return -1;
+        }
+        ing->fd = open(ing->tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (ing->fd < 0) return -1;
+    }
+    sha256_init(&ing->hash);
+    return 0;
+}
+
+static int web_ingest_write(web_ingest_t *ing, const void *buf, size_t len) {
+    sha256_update(&ing->hash, buf, len);
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = write(ing->fd, p, len);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void web_ingest_abort(web_ingest_t *ing) {
+    if (ing->fd >= 0) close(ing->fd);
+    if (!ing->anon && ing->tmp_path[0] != '\0') (void)unlink(ing->tmp_path);
+    ing->fd = -1;
+}
+
+/* Compression-wrapped uploads (see compress.h) hash to the address only
+ * after decoding; re-read the spooled file and check the payload. */
+static int web_ingest_matches_decoded(web_ingest_t *ing, const char *expected_hash) {
+    struct stat st;
+    if (fstat(ing->fd, &st) != 0 || !S_ISREG(st.st_mode)) return 0;
+    size_t len = (size_t)st.st_size;
+    if (len < sizeof(jnk_comp_hdr_t) ||
+        len > (size_t)(1024 * 1024) + sizeof(jnk_comp_hdr_t)) {
+        return 0;
+    }
+
+    uint8_t *fbuf = malloc(len);
+    uint8_t *dec = malloc(1024 * 1024);
+    int ok = 0;
+    if (fbuf && dec && pread(ing->fd, fbuf, len, 0) == (ssize_t)len) {
+        size_t dlen = 0;
+        if (jnk_chunk_decode(fbuf, len, dec, 1024 * 1024, &dlen) > 0) {
+            char hex[65];
+            sha256_buf_hex(dec, dlen, hex);
+            ok = (strcmp(hex, expected_hash) == 0);
+        }
+    }
+    free(fbuf);
+    free(dec);
+    return ok;
+}
+
+/* Returns 0 when the streamed bytes hashed to expected_hash and the
+ * file was placed, -2 on digest mismatch, -1 on I/O error. */
+static int web_ingest_commit(web_ingest_t *ing, const char *expected_hash) {
+    uint8_t digest[32];
+    char hex[65];
+    sha256_final(&ing->hash, digest);
+    sha256_hex(digest, hex);
+    if (strcmp(hex, expected_hash) != 0 &&
+        !web_ingest_matches_decoded(ing, expected_hash)) {
+        web_ingest_abort(ing);
+        return -2;
+    }
+
+    int rc;
+    if (ing->anon) {
+        char proc_path[64];
+        snprintf(proc_path, sizeof(proc_path), "/proc/self/fd/%d", ing->fd);
+        (void)unlink(ing->final_path); /* identical content, if present */
+        rc = linkat(AT_FDCWD, proc_path, AT_FDCWD, ing->final_path,
+                    AT_SYMLINK_FOLLOW) == 0 ? 0 : -1;
+        close(ing->fd);
+    } else {
+        close(ing->fd);
+        rc = rename(ing->tmp_path, ing->final_path) == 0 ? 0 : -1;
+        if (rc != 0) (void)unlink(ing->tmp_path);
+    }
+    ing->fd = -1;
+    return rc;
+}
+
+/* ------------------------- Chunk inventory ------------------------------
+ *
+ * GET /chunks/inventory serves a bloom filter over the local chunk
+ * store (wire format in chunk_inventory.h) so peers can target fetches
+ * at likely holders instead of probing everyone. Peers pass the last
+ * generation they saw as ?gen=<n>; an unchanged filter answers 304 with
+ * no body, so steady-state polls cost one small round trip. The filter
+ * is rebuilt from the store at most every WEB_INV_REBUILD_SEC and
+ * patched in place as chunks arrive over HTTP, so fresh chunks are
+ * advertised without waiting for a rebuild.
+ */
+
+#define WEB_INV_REBUILD_SEC 60
+
+static pthread_mutex_t inv_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t *inv_bits = NULL;
+static uint64_t inv_generation = 0;
+static time_t inv_built_at = 0;
+
+static void inv_scan_store(uint8_t *bits, const char *data_dir) {
+    char base[MAX_PATH_LEN];
+    if (snprintf(base, sizeof(base), "%s/.jnk/chunks/sha256", data_dir) >= (int)sizeof(base)) {
+        return;
+    }
+    DIR *d = opendir(base);
+    if (!d) return;
+    struct dirent *shard;
+    while ((shard = readdir(d)) != NULL) {
+        if (strlen(shard->d_name) != 2) continue;
+        char shard_path[MAX_PATH_LEN];
+        if (snprintf(shard_path, sizeof(shard_path), "%s/%s",
+                     base, shard->d_name) >= (int)sizeof(shard_path)) {
+            continue;
+        }
+        DIR *sd = opendir(shard_path);
+        if (!sd) continue;
+        struct dirent *e;
+        while ((e = readdir(sd)) != NULL) {
+            if (is_hex64(e->d_name)) jnk_inv_set(bits, e->d_name);
+        }
+        closedir(sd);
+    }
+    closedir(d);
+}
+
+/* Rebuild the filter if it is stale; bump the generation only when the
+ * bits actually changed so unchanged polls keep getting 304. Caller
+ * holds inv_lock. */
+static void inv_refresh_locked(junknas_config_t *config) {
+    time_t now = time(NULL);
+    if (inv_bits && now - inv_built_at < WEB_INV_REBUILD_SEC) return;
+    uint8_t *fresh = calloc(1, JNK_INV_BYTES);
+    if (!fresh) return;
+    size_t dir_count = (config->data_dir_count > 0) ? config->data_dir_count : 1;
+    for (size_t i = 0; i < dir_count && i < MAX_DATA_DIRS; i++) {
+        const char *dir = (config->data_dir_count > 0) ? config->data_dirs[i]
+                                                       : config->data_dir;
+        inv_scan_store(fresh, dir);
+    }
+    if (inv_bits && memcmp(inv_bits, fresh, JNK_INV_BYTES) == 0) {
+        free(fresh);
+    } else {
+        free(inv_bits);
+        inv_bits = fresh;
+        inv_generation++;
+    }
+    inv_built_at = now;
+}
+
+/* Fold a freshly received chunk into the filter between rebuilds. */
+static void inv_note_chunk(const char *hash) {
+    pthread_mutex_lock(&inv_lock);
+    if (inv_bits && !jnk_inv_maybe_has(inv_bits, hash)) {
+        jnk_inv_set(inv_bits, hash);
+        inv_generation++;
+    }
+    pthread_mutex_unlock(&inv_lock);
+}
+
+static void respond_chunk_inventory(web_conn_t *conn, const char *query) {
+    uint64_t since = 0;
+    const char *gen = query ? strstr(query, "gen=") : NULL;
+    if (gen) since = strtoull(gen + 4, NULL, 10);
+
+    pthread_mutex_lock(&inv_lock);
+    inv_refresh_locked(conn->config);
+    if (!inv_bits) {
+        pthread_mutex_unlock(&inv_lock);
+        send_status(conn, 500, "Error");
+        return;
+    }
+    if (since != 0 && since == inv_generation) {
+        pthread_mutex_unlock(&inv_lock);
+        send_status(conn, 304, "Not Modified");
+        return;
+    }
+    jnk_inv_hdr_t hdr;
+    memcpy(hdr.magic, JNK_INV_MAGIC, 4);
+    hdr.version = JNK_INV_VERSION;
+    hdr.generation = inv_generation;
+    hdr.bytes = JNK_INV_BYTES;
+    uint8_t *snapshot = malloc(JNK_INV_BYTES);
+    if (snapshot) memcpy(snapshot, inv_bits, JNK_INV_BYTES);
+    pthread_mutex_unlock(&inv_lock);
+    if (!snapshot) {
+        send_status(conn, 500, "Error");
+        return;
+    }
+
+    char header[256];
+    snprintf(header, sizeof(header),
+             "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %zu\r\nConnection: %s\r\n\r\n",
+             sizeof(hdr) + (size_t)JNK_INV_BYTES, conn_header(conn));
+    send_all(conn->fd, header);
+    send(conn->fd, &hdr, sizeof(hdr), 0);
+    send(conn->fd, snapshot, JNK_INV_BYTES, 0);
+    free(snapshot);
+    web_log_verbose(conn->config, "web: served chunk inventory (gen %llu)",
+                    (unsigned long long)hdr.generation);
+}
+
 static void handle_get(web_conn_t *conn, const char *path) {
     if (strcmp(path, "/") == 0) {
-        respond_mount_listing(conn->fd, conn->config, "");
+        respond_mount_listing(conn, "");
         return;
     }
 
     if (strncmp(path, "/browse/", 8) == 0) {
         const char *rel = path + 8;
         if (!is_safe_relative(rel)) {
-            send_status(conn->fd, 400, "Bad Request");
+            send_status(conn, 400, "Bad Request");
             return;
         }
-        respond_mount_listing(conn->fd, conn->config, rel);
+        respond_mount_listing(conn, rel);
         return;
     }
 
     if (strncmp(path, "/files/", 7) == 0) {
         const char *rel = path + 7;
         if (!is_safe_relative(rel)) {
-            send_status(conn->fd, 400, "Bad Request");
+            send_status(conn, 400, "Bad Request");
             return;
         }
         char full_path[MAX_PATH_LEN];
         snprintf(full_path, sizeof(full_path), "%s/%s", conn->config->mount_point, rel);
-        respond_file(conn->fd, full_path);
+        respond_file(conn, full_path);
+        return;
+    }
+
+    if (strncmp(path, "/chunks/inventory", 17) == 0 &&
+        (path[17] == '\0' || path[17] == '?')) {
+        respond_chunk_inventory(conn, path + 17);
         return;
     }
 
     if (strncmp(path, "/chunks/", 8) == 0) {
         const char *hash = path + 8;
         if (!is_hex64(hash)) {
-            send_status(conn->fd, 400, "Bad Request");
+            send_status(conn, 400, "Bad Request");
             return;
         }
         char chunk_path[MAX_PATH_LEN];
         if (find_chunk_path(conn->config, hash, chunk_path, sizeof(chunk_path)) != 0) {
-            send_status(conn->fd, 404, "Not Found");
+            send_status(conn, 404, "Not Found");
             return;
         }
-        respond_file(conn->fd, chunk_path);
+        respond_file(conn, chunk_path);
         return;
     }
 
     if (strcmp(path, "/mesh/peers") == 0) {
-        respond_mesh_state(conn->fd, conn->config);
+        respond_mesh_state(conn);
         return;
     }
 
     if (strcmp(path, "/mesh/config") == 0) {
-        respond_mesh_config(conn->fd, conn->config);
+        respond_mesh_config(conn);
         return;
     }
 
     if (strcmp(path, "/mesh/status") == 0) {
-        respond_mesh_status(conn->fd, conn->config);
+        respond_mesh_status(conn);
         return;
     }
 
     if (strcmp(path, "/mesh/ui") == 0 || strcmp(path, "/mesh") == 0) {
-        respond_mesh_ui(conn->fd);
+        respond_mesh_ui(conn);
         return;
     }
 
-    send_status(conn->fd, 404, "Not Found");
-}
-
-static int read_headers(int fd, char *buf, size_t buf_len, size_t *out_len) {
-    size_t used = 0;
-    while (used + 1 < buf_len) {
-        ssize_t n = recv(fd, buf + used, buf_len - used - 1, 0);
-        if (n <= 0) break;
-        used += (size_t)n;
-        buf[used] = '\0';
-        if (strstr(buf, "\r\n\r\n")) {
-            if (out_len) *out_len = used;
-            return 0;
+    if (strcmp(path, "/metrics") == 0) {
+        char *body = jnk_metrics_render();
+        if (!body) {
+            send_status(conn, 500, "Error");
+            return;
         }
+        send_text(conn, 200, body);
+        free(body);
+        return;
     }
-    return -1;
+
+    send_status(conn, 404, "Not Found");
 }
 
 static const char *find_header_case_insensitive(const char *headers, const char *needle) {
@@ -1267,66 +1501,314 @@ static long parse_content_length(const char *headers) {
 
 static void handle_post_chunk(web_conn_t *conn, const char *hash, const char *headers, const char *body, size_t body_len) {
     if (!is_hex64(hash)) {
-        send_status(conn->fd, 400, "Bad Request");
+        send_status(conn, 400, "Bad Request");
         return;
     }
 
     long content_len = parse_content_length(headers);
     if (content_len < 0) {
-        send_status(conn->fd, 411, "Length Required");
+        send_status(conn, 411, "Length Required");
         return;
     }
 
     char chunk_path[MAX_PATH_LEN];
     const char *dir = (conn->config->data_dir_count > 0) ? conn->config->data_dirs[0] : conn->config->data_dir;
     if (chunk_path_for_hash(dir, hash, chunk_path, sizeof(chunk_path)) != 0) {
-        send_status(conn->fd, 400, "Bad Request");
+        send_status(conn, 400, "Bad Request");
         return;
     }
-    ensure_parent_dir(chunk_path);
 
-    int out = open(chunk_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (out < 0) {
-        send_status(conn->fd, 500, "Error");
+    web_ingest_t ing;
+    if (web_ingest_begin(&ing, chunk_path) != 0) {
+        send_status(conn, 500, "Error");
         return;
     }
 
-    if (body_len > 0) {
-        write(out, body, body_len);
+    char *buf = NULL;
+    if (posix_memalign((void **)&buf, 4096, WEB_INGEST_BUF) != 0) {
+        web_ingest_abort(&ing);
+        send_status(conn, 500, "Error");
+        return;
     }
-    size_t remaining = (size_t)content_len > body_len ? (size_t)content_len - body_len : 0;
-    char buf[4096];
-    while (remaining > 0) {
-        ssize_t n = recv(conn->fd, buf, remaining > sizeof(buf) ? sizeof(buf) : remaining, 0);
-        if (n <= 0) break;
-        write(out, buf, (size_t)n);
+
+    int failed = 0;
+    size_t have = body_len < (size_t)content_len ? body_len : (size_t)content_len;
+    if (have > 0 && web_ingest_write(&ing, body, have) != 0) failed = 1;
+    size_t remaining = (size_t)content_len - have;
+    while (!failed && remaining > 0) {
+        size_t ask = remaining > WEB_INGEST_BUF ? WEB_INGEST_BUF : remaining;
+        ssize_t n = recv(conn->fd, buf, ask, 0);
+        if (n <= 0 || web_ingest_write(&ing, buf, (size_t)n) != 0) {
+            failed = 1;
+            break;
+        }
         remaining -= (size_t)n;
     }
-    close(out);
+    free(buf);
+    if (!failed) conn->body_unread = 0;    /* payload fully drained */
+
+    if (failed) {
+        web_ingest_abort(&ing);
+        send_status(conn, 500, "Error");
+        return;
+    }
+
+    int rc = web_ingest_commit(&ing, hash);
+    if (rc == -2) {
+        web_log_verbose(conn->config, "web: rejected chunk %s (digest mismatch)", hash);
+        send_status(conn, 400, "Bad Request");
+        return;
+    }
+    if (rc != 0) {
+        send_status(conn, 500, "Error");
+        return;
+    }
+    inv_note_chunk(hash);
 
-    send_text(conn->fd, 200, "OK\n");
+    send_text(conn, 200, "OK\n");
 }
 
-static void handle_connection(web_conn_t *conn) {
-    char buf[WEB_BUF_SIZE];
-    size_t header_len = 0;
-    if (read_headers(conn->fd, buf, sizeof(buf), &header_len) != 0) {
-        send_status(conn->fd, 400, "Bad Request");
+/* ------------------------- Batched chunk transfer -----------------------
+ *
+ * Moving one chunk per request costs a round trip per chunk, which
+ * dominates cross-site restores. The batch endpoints move many chunks
+ * per request with a simple length-prefixed framing: each entry is one
+ * header line "<hash> <length>\n" followed by exactly <length> raw
+ * payload bytes, where a length of -1 marks a chunk this node does not
+ * have (and carries no payload).
+ *
+ *   POST /chunks/batch        body: one hash per line; response: entries
+ *   POST /chunks/batch-upload body: entries; response: plain "OK"
+ */
+
+/* Sequential reader over a request body: drains the part already pulled
+ * into the header buffer before reading the rest from the socket. */
+typedef struct {
+    int fd;
+    const char *pre;
+    size_t pre_len;
+    size_t pre_off;
+    size_t remaining;                  /* body bytes not yet returned */
+} web_body_reader_t;
+
+static ssize_t web_body_read(web_body_reader_t *r, void *buf, size_t len) {
+    if (r->remaining == 0) return 0;
+    if (len > r->remaining) len = r->remaining;
+    if (r->pre_off < r->pre_len) {
+        size_t take = r->pre_len - r->pre_off;
+        if (take > len) take = len;
+        memcpy(buf, r->pre + r->pre_off, take);
+        r->pre_off += take;
+        r->remaining -= take;
+        return (ssize_t)take;
+    }
+    ssize_t n = recv(r->fd, buf, len, 0);
+    if (n > 0) r->remaining -= (size_t)n;
+    return n;
+}
+
+static int web_body_read_line(web_body_reader_t *r, char *line, size_t line_len) {
+    size_t used = 0;
+    while (used + 1 < line_len) {
+        char c;
+        if (web_body_read(r, &c, 1) != 1) return -1;
+        if (c == '\n') {
+            line[used] = '\0';
+            return 0;
+        }
+        line[used++] = c;
+    }
+    return -1;
+}
+
+/* Stream exactly want bytes of path to the socket, zero-padding if the
+ * file shrank after it was measured, so the batch framing stays intact. */
+static void stream_file_exact(int fd, const char *path, size_t want) {
+    int in = open(path, O_RDONLY);
+    char buf[4096];
+    size_t sent = 0;
+    if (in >= 0) {
+        sent = send_file_contents(fd, in, want);
+        close(in);
+    }
+    memset(buf, 0, sizeof(buf));
+    while (sent < want) {
+        size_t pad = want - sent;
+        if (pad > sizeof(buf)) pad = sizeof(buf);
+        send(fd, buf, pad, 0);
+        sent += pad;
+    }
+}
+
+static void handle_post_chunk_batch(web_conn_t *conn, const char *headers,
+                                    const char *body, size_t body_len) {
+    long content_len = parse_content_length(headers);
+    if (content_len < 0) {
+        send_status(conn, 411, "Length Required");
+        return;
+    }
+    if (content_len > WEB_BATCH_MAX * 66) {
+        send_status(conn, 413, "Payload Too Large");
         return;
     }
 
-    char *header_end = strstr(buf, "\r\n\r\n");
-    if (!header_end) {
-        send_status(conn->fd, 400, "Bad Request");
+    web_body_reader_t reader = { conn->fd, body, body_len, 0, (size_t)content_len };
+    char (*hashes)[65] = calloc(WEB_BATCH_MAX, sizeof(*hashes));
+    long long *lens = calloc(WEB_BATCH_MAX, sizeof(*lens));
+    char (*paths)[MAX_PATH_LEN] = calloc(WEB_BATCH_MAX, sizeof(*paths));
+    if (!hashes || !lens || !paths) {
+        free(hashes); free(lens); free(paths);
+        send_status(conn, 500, "Error");
         return;
     }
-    size_t body_len = header_len - (size_t)(header_end + 4 - buf);
-    const char *body = header_end + 4;
 
+    int count = 0;
+    char line[128];
+    while (count < WEB_BATCH_MAX && web_body_read_line(&reader, line, sizeof(line)) == 0) {
+        if (line[0] == '\0') continue;
+        if (!is_hex64(line)) {
+            free(hashes); free(lens); free(paths);
+            send_status(conn, 400, "Bad Request");
+            return;
+        }
+        memcpy(hashes[count], line, 65);
+        count++;
+    }
+    if (reader.remaining == 0) conn->body_unread = 0;
+
+    /* Measure everything up front so the response can carry an exact
+     * Content-Length and the connection stays reusable. */
+    unsigned long long total = 0;
+    char entry[128];
+    for (int i = 0; i < count; i++) {
+        struct stat st;
+        lens[i] = -1;
+        if (find_chunk_path(conn->config, hashes[i], paths[i], sizeof(paths[i])) == 0 &&
+            stat(paths[i], &st) == 0 && S_ISREG(st.st_mode)) {
+            lens[i] = (long long)st.st_size;
+        }
+        total += (unsigned long long)snprintf(entry, sizeof(entry), "%s %lld\n",
+                                              hashes[i], lens[i]);
+        if (lens[i] > 0) total += (unsigned long long)lens[i];
+    }
+
+    char header[256];
+    snprintf(header, sizeof(header),
+             "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %llu\r\nConnection: %s\r\n\r\n",
+             total, conn_header(conn));
+    send_all(conn->fd, header);
+
+    for (int i = 0; i < count; i++) {
+        snprintf(entry, sizeof(entry), "%s %lld\n", hashes[i], lens[i]);
+        send_all(conn->fd, entry);
+        if (lens[i] > 0) stream_file_exact(conn->fd, paths[i], (size_t)lens[i]);
+    }
+
+    web_log_verbose(conn->config, "web: served chunk batch (%d hashes)", count);
+    free(hashes);
+    free(lens);
+    free(paths);
+}
+
+static void handle_post_chunk_batch_upload(web_conn_t *conn, const char *headers,
+                                           const char *body, size_t body_len) {
+    long content_len = parse_content_length(headers);
+    if (content_len < 0) {
+        send_status(conn, 411, "Length Required");
+        return;
+    }
+
+    web_body_reader_t reader = { conn->fd, body, body_len, 0, (size_t)content_len };
+    const char *dir = (conn->config->data_dir_count > 0) ? conn->config->data_dirs[0]
+                                                         : conn->config->data_dir;
+    char *buf = NULL;
+    if (posix_memalign((void **)&buf, 4096, WEB_INGEST_BUF) != 0) {
+        send_status(conn, 500, "Error");
+        return;
+    }
+
+    int stored = 0;
+    char line[128];
+    while (reader.remaining > 0) {
+        if (web_body_read_line(&reader, line, sizeof(line)) != 0) {
+            free(buf);
+            send_status(conn, 400, "Bad Request");
+            return;
+        }
+        char hash[65];
+        long long len = -1;
+        if (sscanf(line, "%64s %lld", hash, &len) != 2 || !is_hex64(hash) ||
+            len < 0 || len > (long long)WEB_BATCH_CHUNK_MAX) {
+            free(buf);
+            send_status(conn, 400, "Bad Request");
+            return;
+        }
+
+        char chunk_path[MAX_PATH_LEN];
+        if (chunk_path_for_hash(dir, hash, chunk_path, sizeof(chunk_path)) != 0) {
+            free(buf);
+            send_status(conn, 400, "Bad Request");
+            return;
+        }
+
+        /* A failed ingest still drains the payload so the batch framing
+         * stays aligned for the entries after it. */
+        web_ingest_t ing;
+        int ok = web_ingest_begin(&ing, chunk_path) == 0;
+        size_t remaining = (size_t)len;
+        while (remaining > 0) {
+            size_t ask = remaining > WEB_INGEST_BUF ? WEB_INGEST_BUF : remaining;
+            ssize_t n = web_body_read(&reader, buf, ask);
+            if (n <= 0) {
+                if (ok) web_ingest_abort(&ing);
+                free(buf);
+                send_status(conn, 400, "Bad Request");
+                return;
+            }
+            if (ok && web_ingest_write(&ing, buf, (size_t)n) != 0) {
+                web_ingest_abort(&ing);
+                ok = 0;
+            }
+            remaining -= (size_t)n;
+        }
+        if (ok) {
+            int rc = web_ingest_commit(&ing, hash);
+            if (rc == 0) {
+                inv_note_chunk(hash);
+                stored++;
+            } else if (rc == -2) {
+                web_log_verbose(conn->config, "web: rejected chunk %s (digest mismatch)", hash);
+            }
+        }
+    }
+    free(buf);
+    conn->body_unread = 0;                 /* loop ran the body dry */
+
+    web_log_verbose(conn->config, "web: stored chunk batch (%d chunks)", stored);
+    send_text(conn, 200, "OK\n");
+}
+
+/* Whether the client asked to keep the connection open: HTTP/1.1
+ * defaults to keep-alive unless the request says Connection: close. */
+static int request_wants_keepalive(const char *headers) {
+    const char *eol = strstr(headers, "\r\n");
+    const char *ver = strstr(headers, " HTTP/1.1");
+    if (!ver || (eol && ver > eol)) return 0;
+    const char *c = find_header_case_insensitive(headers, "Connection:");
+    if (c) {
+        c += strlen("Connection:");
+        while (*c == ' ' || *c == '\t') c++;
+        if (strncasecmp(c, "close", 5) == 0) return 0;
+    }
+    return 1;
+}
+
+static void handle_request(web_conn_t *conn, const char *buf,
+                           const char *body, size_t body_len) {
     char method[8];
     char path[512];
     if (sscanf(buf, "%7s %511s", method, path) != 2) {
-        send_status(conn->fd, 400, "Bad Request");
+        send_status(conn, 400, "Bad Request");
         return;
     }
 
@@ -1339,59 +1821,64 @@ static void handle_connection(web_conn_t *conn) {
         if (strcmp(path, "/mesh/peers") == 0) {
             int updated = merge_mesh_payload(conn->config, body);
             if (updated >= 0) {
-                respond_mesh_state(conn->fd, conn->config);
+                respond_mesh_state(conn);
             } else {
-                send_status(conn->fd, 400, "Bad Request");
+                send_status(conn, 400, "Bad Request");
             }
             return;
         }
         if (strcmp(path, "/mesh/bootstrap") == 0) {
-            (void)respond_mesh_bootstrap(conn->fd, conn->config);
+            (void)respond_mesh_bootstrap(conn);
             return;
         }
         if (strcmp(path, "/mesh/join") == 0) {
-            (void)respond_mesh_join(conn->fd, conn->config, body);
+            (void)respond_mesh_join(conn, body);
             return;
         }
         if (strcmp(path, "/mesh/alternate") == 0) {
-            (void)respond_mesh_alternate(conn->fd, conn->config, body);
+            (void)respond_mesh_alternate(conn, body);
             return;
         }
         if (strcmp(path, "/mesh/config") == 0) {
             if (update_mesh_config(conn->config, body) == 0) {
-                respond_mesh_config(conn->fd, conn->config);
+                respond_mesh_config(conn);
             } else {
-                send_status(conn->fd, 400, "Bad Request");
+                send_status(conn, 400, "Bad Request");
             }
             return;
         }
         if (strcmp(path, "/mesh/sync") == 0) {
             cJSON *payload_json = build_mesh_state_json(conn->config);
             if (!payload_json) {
-                send_status(conn->fd, 500, "Error");
+                send_status(conn, 500, "Error");
                 return;
             }
             char *payload = cJSON_PrintUnformatted(payload_json);
             cJSON_Delete(payload_json);
             if (!payload) {
-                send_status(conn->fd, 500, "Error");
+                send_status(conn, 500, "Error");
                 return;
             }
 
-            junknas_config_lock(conn->config);
-            int bootstrap_count = conn->config->bootstrap_peer_count;
+            junknas_config_snapshot_t *snap = junknas_config_snapshot_get(conn->config);
+            if (!snap) {
+                free(payload);
+                send_status(conn, 500, "Error");
+                return;
+            }
+            int bootstrap_count = snap->bootstrap_peer_count;
             char bootstrap[MAX_BOOTSTRAP_PEERS][MAX_ENDPOINT_LEN];
             for (int i = 0; i < bootstrap_count; i++) {
-                snprintf(bootstrap[i], sizeof(bootstrap[i]), "%s", conn->config->bootstrap_peers[i]);
+                snprintf(bootstrap[i], sizeof(bootstrap[i]), "%s", snap->bootstrap_peers[i]);
             }
-            int wg_count = conn->config->wg_peer_count;
+            int wg_count = snap->wg_peer_count;
             junknas_wg_peer_t wg_peers[MAX_WG_PEERS];
             if (wg_count > MAX_WG_PEERS) wg_count = MAX_WG_PEERS;
             for (int i = 0; i < wg_count; i++) {
-                wg_peers[i] = conn->config->wg_peers[i];
+                wg_peers[i] = snap->wg_peers[i];
             }
-            uint16_t default_web_port = conn->config->web_port;
-            junknas_config_unlock(conn->config);
+            uint16_t default_web_port = snap->web_port;
+            junknas_config_snapshot_put(snap);
 
             int synced = 0;
             for (int i = 0; i < bootstrap_count; i++) {
@@ -1416,58 +1903,258 @@ static void handle_connection(web_conn_t *conn) {
                 junknas_config_unlock(conn->config);
                 if (rc == 0) synced++;
             }
+            junknas_config_publish(conn->config);
 
             free(payload);
             char response[128];
             snprintf(response, sizeof(response), "{\"synced\":%d}", synced);
-            send_json(conn->fd, 200, response);
+            send_json(conn, 200, response);
+            return;
+        }
+        if (strcmp(path, "/chunks/batch") == 0) {
+            handle_post_chunk_batch(conn, buf, body, body_len);
+            return;
+        }
+        if (strcmp(path, "/chunks/batch-upload") == 0) {
+            handle_post_chunk_batch_upload(conn, buf, body, body_len);
             return;
         }
         if (strncmp(path, "/chunks/", 8) == 0) {
             handle_post_chunk(conn, path + 8, buf, body, body_len);
             return;
         }
-        send_status(conn->fd, 404, "Not Found");
+        send_status(conn, 404, "Not Found");
         return;
     }
 
-    send_status(conn->fd, 405, "Method Not Allowed");
+    send_status(conn, 405, "Method Not Allowed");
 }
 
-static void *connection_thread(void *arg) {
-    web_conn_t *conn = (web_conn_t *)arg;
-    handle_connection(conn);
-    close(conn->fd);
-    free(conn);
-    return NULL;
+/* Serve requests off one connection until the client closes, asks for
+ * close, a handler breaks the framing, the socket's read timeout
+ * (WEB_IO_TIMEOUT_SEC, set by the worker) trips mid-request, or the
+ * buffered bytes run out between requests. Bytes read past one request's
+ * body are kept for the next, so pipelined requests work. Returns 1 when
+ * the connection is idle keep-alive and should go back to the epoll set,
+ * 0 when the caller should close it. */
+static int handle_connection(web_conn_t *conn) {
+    char buf[WEB_BUF_SIZE];
+    size_t used = 0;
+    buf[0] = '\0';
+
+    for (;;) {
+        char *header_end;
+        while ((header_end = strstr(buf, "\r\n\r\n")) == NULL) {
+            if (used + 1 >= sizeof(buf)) {
+                send_status(conn, 431, "Request Header Fields Too Large");
+                return 0;
+            }
+            ssize_t n = recv(conn->fd, buf + used, sizeof(buf) - used - 1, 0);
+            if (n <= 0) return 0;      /* closed, or stalled mid-request */
+            used += (size_t)n;
+            buf[used] = '\0';
+        }
+
+        size_t req_len = (size_t)(header_end + 4 - buf);
+        size_t body_len = used - req_len;
+        const char *body = buf + req_len;
+
+        /* Parse the framing headers with the block NUL-terminated so a
+         * pipelined request sitting behind it cannot be misread. */
+        char saved = buf[req_len];
+        buf[req_len] = '\0';
+        conn->keep_alive = request_wants_keepalive(buf);
+        long content_len = parse_content_length(buf);
+
+        /* Body bytes beyond what is buffered stay on the socket unless a
+         * handler drains them; handlers that do clear the flag. A POST
+         * without Content-Length has no body framing at all, so an error
+         * response to it must close too. */
+        conn->body_unread = content_len > (long)body_len ||
+                            (content_len < 0 && strncmp(buf, "POST ", 5) == 0);
+
+        if (content_len < 0) content_len = 0;
+        buf[req_len] = saved;
+
+        handle_request(conn, buf, body, body_len);
+
+        if (!conn->keep_alive) return 0;
+
+        /* Drop this request and however much of its body landed in the
+         * buffer; the handlers consumed the rest from the socket. */
+        size_t in_buf = (size_t)content_len < body_len ? (size_t)content_len : body_len;
+        size_t next_off = req_len + in_buf;
+        memmove(buf, buf + next_off, used - next_off);
+        used -= next_off;
+        buf[used] = '\0';
+
+        /* Nothing pipelined: park the socket in epoll instead of sitting
+         * in recv() and holding this worker hostage until the client's
+         * next request (or the 30 s timeout). */
+        if (used == 0) return 1;
+    }
+}
+
+/* ------------------------- Connection handling --------------------------
+ *
+ * One epoll loop owns the listening socket, every accepted socket until
+ * its first bytes arrive, and every keep-alive socket between requests;
+ * a fixed pool of WEB_WORKERS threads runs the (blocking) protocol
+ * handlers above on sockets that became readable. An idle connection
+ * costs a little epoll state instead of a parked thread, and a sync
+ * storm no longer creates a thread per request. Parked keep-alive
+ * sockets carry a deadline; the epoll loop reaps any that stay silent
+ * past it.
+ */
+
+static int set_nonblocking(int fd, int on) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    if (on) flags |= O_NONBLOCK;
+    else flags &= ~O_NONBLOCK;
+    return fcntl(fd, F_SETFL, flags);
+}
+
+/* Remove fd from the parked table (no-op when it is not there). Called
+ * by the epoll loop before dispatching a parked socket so the idle
+ * sweep cannot close a connection a worker is serving. */
+static void server_idle_forget(struct junknas_web_server *server, int fd) {
+    pthread_mutex_lock(&server->idle_lock);
+    for (int i = 0; i < server->idle_count; i++) {
+        if (server->idle[i].fd == fd) {
+            server->idle[i] = server->idle[server->idle_count - 1];
+            server->idle_count--;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&server->idle_lock);
+}
+
+/* Hand an idle keep-alive socket back to the epoll loop with a fresh
+ * deadline. Returns 0 when parked; on failure the caller closes the
+ * socket. Registered one-shot, same as freshly accepted sockets. */
+static int server_idle_park(struct junknas_web_server *server, int fd) {
+    pthread_mutex_lock(&server->idle_lock);
+    if (server->idle_count == WEB_IDLE_MAX) {
+        pthread_mutex_unlock(&server->idle_lock);
+        return -1;
+    }
+    server->idle[server->idle_count].fd = fd;
+    server->idle[server->idle_count].deadline = time(NULL) + WEB_IO_TIMEOUT_SEC;
+    server->idle_count++;
+    pthread_mutex_unlock(&server->idle_lock);
+
+    (void)set_nonblocking(fd, 1);
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+    ev.data.fd = fd;
+    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        server_idle_forget(server, fd);
+        return -1;
+    }
+    return 0;
+}
+
+static void *worker_thread(void *arg) {
+    struct junknas_web_server *server = (struct junknas_web_server *)arg;
+    for (;;) {
+        pthread_mutex_lock(&server->ready_lock);
+        while (server->ready_count == 0 && !server->stop) {
+            pthread_cond_wait(&server->ready_cond, &server->ready_lock);
+        }
+        if (server->ready_count == 0) {
+            pthread_mutex_unlock(&server->ready_lock);
+            return NULL;
+        }
+        int fd = server->ready[server->ready_head];
+        server->ready_head = (server->ready_head + 1) % WEB_PENDING_MAX;
+        server->ready_count--;
+        pthread_mutex_unlock(&server->ready_lock);
+
+        /* The protocol handlers read bodies and send responses in
+         * blocking style; only the wait for the first bytes is async.
+         * The timeout keeps a stalled client from wedging a worker. */
+        (void)set_nonblocking(fd, 0);
+        struct timeval tv = { WEB_IO_TIMEOUT_SEC, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        web_conn_t conn = { fd, server->config, 0, 0 };
+        if (handle_connection(&conn) && !server->stop &&
+            server_idle_park(server, fd) == 0) {
+            continue;                  /* idle keep-alive: back to epoll */
+        }
+        close(fd);
+    }
+}
+
+static void server_dispatch(struct junknas_web_server *server, int fd) {
+    pthread_mutex_lock(&server->ready_lock);
+    if (server->ready_count == WEB_PENDING_MAX) {
+        pthread_mutex_unlock(&server->ready_lock);
+        web_log_verbose(server->config, "web: worker queue full, dropping connection");
+        close(fd);
+        return;
+    }
+    server->ready[(server->ready_head + server->ready_count) % WEB_PENDING_MAX] = fd;
+    server->ready_count++;
+    pthread_cond_signal(&server->ready_cond);
+    pthread_mutex_unlock(&server->ready_lock);
 }
 
 static void *server_thread(void *arg) {
     struct junknas_web_server *server = (struct junknas_web_server *)arg;
+    struct epoll_event events[WEB_EPOLL_EVENTS];
+
     while (!server->stop) {
-        struct sockaddr_in addr;
-        socklen_t addr_len = sizeof(addr);
-        int client = accept(server->fd, (struct sockaddr *)&addr, &addr_len);
-        if (client < 0) {
+        int n = epoll_wait(server->epoll_fd, events, WEB_EPOLL_EVENTS, 500);
+        if (n < 0) {
             if (errno == EINTR) continue;
             break;
         }
+        for (int e = 0; e < n; e++) {
+            if (events[e].data.fd == server->fd) {
+                for (;;) {
+                    struct sockaddr_in addr;
+                    socklen_t addr_len = sizeof(addr);
+                    int client = accept(server->fd, (struct sockaddr *)&addr, &addr_len);
+                    if (client < 0) break;
+                    (void)set_nonblocking(client, 1);
+                    struct epoll_event ev;
+                    memset(&ev, 0, sizeof(ev));
+                    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+                    ev.data.fd = client;
+                    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, client, &ev) != 0) {
+                        close(client);
+                    }
+                }
+                continue;
+            }
 
-        web_conn_t *conn = calloc(1, sizeof(*conn));
-        if (!conn) {
-            close(client);
-            continue;
+            int client = events[e].data.fd;
+            (void)epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, client, NULL);
+            server_idle_forget(server, client);
+            if (!(events[e].events & EPOLLIN)) {
+                close(client);         /* hung up before sending anything */
+                continue;
+            }
+            server_dispatch(server, client);
         }
-        conn->fd = client;
-        conn->config = server->config;
 
-        pthread_t tid;
-        if (pthread_create(&tid, NULL, connection_thread, conn) == 0) {
-            pthread_detach(tid);
-        } else {
-            close(client);
-            free(conn);
+        /* Reap parked keep-alive sockets idle past their deadline;
+         * close() also drops them from the epoll set. */
+        time_t now = time(NULL);
+        pthread_mutex_lock(&server->idle_lock);
+        for (int i = 0; i < server->idle_count; ) {
+            if (server->idle[i].deadline <= now) {
+                close(server->idle[i].fd);
+                server->idle[i] = server->idle[server->idle_count - 1];
+                server->idle_count--;
+            } else {
+                i++;
+            }
         }
+        pthread_mutex_unlock(&server->idle_lock);
     }
     return NULL;
 }
@@ -1512,21 +2199,85 @@ junknas_web_server_t *junknas_web_server_start(junknas_config_t *config) {
         return NULL;
     }
 
-    if (pthread_create(&server->thread, NULL, server_thread, server) != 0) {
-        web_log_verbose(config, "web: failed to start web server thread");
+    server->epoll_fd = epoll_create1(0);
+    if (server->epoll_fd < 0) {
+        web_log_verbose(config, "web: failed to create epoll instance");
+        close(server->fd);
+        free(server);
+        return NULL;
+    }
+    (void)set_nonblocking(server->fd, 1);
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = server->fd;
+    if (epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->fd, &ev) != 0) {
+        web_log_verbose(config, "web: failed to register listen socket");
+        close(server->epoll_fd);
         close(server->fd);
         free(server);
         return NULL;
     }
 
-    web_log_verbose(config, "web: server listening on port %u", config->web_port);
+    pthread_mutex_init(&server->ready_lock, NULL);
+    pthread_cond_init(&server->ready_cond, NULL);
+    pthread_mutex_init(&server->idle_lock, NULL);
+    for (int i = 0; i < WEB_WORKERS; i++) {
+        if (pthread_create(&server->workers[i], NULL, worker_thread, server) != 0) {
+            break;
+        }
+        server->worker_count++;
+    }
+
+    if (server->worker_count == 0 ||
+        pthread_create(&server->thread, NULL, server_thread, server) != 0) {
+        web_log_verbose(config, "web: failed to start web server threads");
+        server->stop = 1;
+        pthread_mutex_lock(&server->ready_lock);
+        pthread_cond_broadcast(&server->ready_cond);
+        pthread_mutex_unlock(&server->ready_lock);
+        for (int i = 0; i < server->worker_count; i++) {
+            pthread_join(server->workers[i], NULL);
+        }
+        pthread_cond_destroy(&server->ready_cond);
+        pthread_mutex_destroy(&server->ready_lock);
+        pthread_mutex_destroy(&server->idle_lock);
+        close(server->epoll_fd);
+        close(server->fd);
+        free(server);
+        return NULL;
+    }
+
+    web_log_verbose(config, "web: server listening on port %u (%d workers)",
+                    config->web_port, server->worker_count);
     return server;
 }
 
 void junknas_web_server_stop(junknas_web_server_t *server) {
     if (!server) return;
     server->stop = 1;
-    if (server->fd >= 0) close(server->fd);
     pthread_join(server->thread, NULL);
+
+    pthread_mutex_lock(&server->ready_lock);
+    pthread_cond_broadcast(&server->ready_cond);
+    pthread_mutex_unlock(&server->ready_lock);
+    for (int i = 0; i < server->worker_count; i++) {
+        pthread_join(server->workers[i], NULL);
+    }
+    while (server->ready_count > 0) {
+        close(server->ready[server->ready_head]);
+        server->ready_head = (server->ready_head + 1) % WEB_PENDING_MAX;
+        server->ready_count--;
+    }
+    while (server->idle_count > 0) {
+        server->idle_count--;
+        close(server->idle[server->idle_count].fd);
+    }
+
+    pthread_cond_destroy(&server->ready_cond);
+    pthread_mutex_destroy(&server->ready_lock);
+    pthread_mutex_destroy(&server->idle_lock);
+    close(server->epoll_fd);
+    if (server->fd >= 0) close(server->fd);
     free(server);
 }
@@ -1451,6 +1451,145 @@ out:
 	return ret;
 }
 
+static bool sync_endpoint_equal(const wg_endpoint *a, const wg_endpoint *b)
+{
+	if (a->addr.sa_family != b->addr.sa_family)
+		return false;
+	if (a->addr.sa_family == AF_INET)
+		return a->addr4.sin_port == b->addr4.sin_port && !memcmp(&a->addr4.sin_addr, &b->addr4.sin_addr, sizeof(a->addr4.sin_addr));
+	if (a->addr.sa_family == AF_INET6)
+		return a->addr6.sin6_port == b->addr6.sin6_port && !memcmp(&a->addr6.sin6_addr, &b->addr6.sin6_addr, sizeof(a->addr6.sin6_addr));
+	return true;
+}
+
+static bool sync_has_allowedip(const wg_peer *peer, const wg_allowedip *ip)
+{
+	const wg_allowedip *cur;
+
+	wg_for_each_allowedip(peer, cur) {
+		if (cur->family != ip->family || cur->cidr != ip->cidr)
+			continue;
+		if (ip->family == AF_INET && !memcmp(&cur->ip4, &ip->ip4, sizeof(ip->ip4)))
+			return true;
+		if (ip->family == AF_INET6 && !memcmp(&cur->ip6, &ip->ip6, sizeof(ip->ip6)))
+			return true;
+	}
+	return false;
+}
+
+static bool sync_peer_unchanged(const wg_peer *want, const wg_peer *have)
+{
+	const wg_allowedip *ip;
+	unsigned int want_ips = 0, have_ips = 0;
+
+	if (want->endpoint.addr.sa_family && !sync_endpoint_equal(&want->endpoint, &have->endpoint))
+		return false;
+	if ((want->flags & WGPEER_HAS_PRESHARED_KEY) && memcmp(want->preshared_key, have->preshared_key, sizeof(wg_key)))
+		return false;
+	if ((want->flags & WGPEER_HAS_PERSISTENT_KEEPALIVE_INTERVAL) && want->persistent_keepalive_interval != have->persistent_keepalive_interval)
+		return false;
+	wg_for_each_allowedip(want, ip) {
+		++want_ips;
+		if (!sync_has_allowedip(have, ip))
+			return false;
+	}
+	wg_for_each_allowedip(have, ip)
+		++have_ips;
+	return want_ips == have_ips;
+}
+
+int wg_sync_device(wg_device *dev)
+{
+	wg_device *have = NULL, delta = { 0 };
+	wg_peer *peer, *cur, *copy;
+	int ret;
+
+	ret = wg_get_device(&have, dev->name);
+	if (ret)
+		return ret;
+
+	memcpy(delta.name, dev->name, sizeof(delta.name));
+	if ((dev->flags & WGDEVICE_HAS_PRIVATE_KEY) && memcmp(dev->private_key, have->private_key, sizeof(wg_key))) {
+		memcpy(delta.private_key, dev->private_key, sizeof(wg_key));
+		delta.flags |= WGDEVICE_HAS_PRIVATE_KEY;
+	}
+	if ((dev->flags & WGDEVICE_HAS_LISTEN_PORT) && dev->listen_port != have->listen_port) {
+		delta.listen_port = dev->listen_port;
+		delta.flags |= WGDEVICE_HAS_LISTEN_PORT;
+	}
+	if ((dev->flags & WGDEVICE_HAS_FWMARK) && dev->fwmark != have->fwmark) {
+		delta.fwmark = dev->fwmark;
+		delta.flags |= WGDEVICE_HAS_FWMARK;
+	}
+
+	/* Peers the kernel has that dev no longer wants: remove by public key */
+	wg_for_each_peer(have, cur) {
+		bool keep = false;
+
+		wg_for_each_peer(dev, peer) {
+			if (!memcmp(peer->public_key, cur->public_key, sizeof(wg_key))) {
+				keep = true;
+				break;
+			}
+		}
+		if (keep)
+			continue;
+		copy = calloc(1, sizeof(wg_peer));
+		if (!copy)
+			goto oom;
+		memcpy(copy->public_key, cur->public_key, sizeof(wg_key));
+		copy->flags = WGPEER_HAS_PUBLIC_KEY | WGPEER_REMOVE_ME;
+		if (delta.last_peer)
+			delta.last_peer->next_peer = copy;
+		else
+			delta.first_peer = copy;
+		delta.last_peer = copy;
+	}
+
+	/* New or changed peers: send the full peer, replacing allowed IPs so
+	 * stale routes die in the same message. Untouched peers are skipped
+	 * entirely, leaving their handshakes and counters alone. */
+	wg_for_each_peer(dev, peer) {
+		wg_peer *existing = NULL;
+
+		wg_for_each_peer(have, cur) {
+			if (!memcmp(peer->public_key, cur->public_key, sizeof(wg_key))) {
+				existing = cur;
+				break;
+			}
+		}
+		if (existing && sync_peer_unchanged(peer, existing))
+			continue;
+		copy = calloc(1, sizeof(wg_peer));
+		if (!copy)
+			goto oom;
+		*copy = *peer; /* allowed IP list is borrowed from dev, not owned */
+		copy->flags |= WGPEER_REPLACE_ALLOWEDIPS;
+		copy->next_peer = NULL;
+		if (delta.last_peer)
+			delta.last_peer->next_peer = copy;
+		else
+			delta.first_peer = copy;
+		delta.last_peer = copy;
+	}
+
+	if (!delta.flags && !delta.first_peer)
+		ret = 0; /* already converged: nothing on the wire */
+	else
+		ret = wg_set_device(&delta);
+	goto out;
+oom:
+	ret = -errno;
+out:
+	while ((copy = delta.first_peer)) {
+		delta.first_peer = copy->next_peer;
+		free(copy);
+	}
+	wg_free_device(have);
+	errno = -ret;
+	return ret;
+}
+
 /* first\0second\0third\0forth\0last\0\0 */
 char *wg_list_device_names(void)
 {